@@ -0,0 +1,327 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#ifndef _PUPPY_ALLOCATION_HPP
+#define _PUPPY_ALLOCATION_HPP
+
+#include "export.hpp"
+#include "platform.hpp"
+#include <cstddef>
+#include <memory>
+#include <source_location>
+#include <type_traits>
+
+// --- 割り当ての追跡
+// 無効の場合は追跡に関するコードを一切生成しない
+#ifndef PUPPY_ALLOCATION_TRACKING
+	#define PUPPY_ALLOCATION_TRACKING 0
+#endif
+
+namespace puppy
+{
+	/// @brief 割り当ての追跡が有効であるか
+	inline constexpr bool allocation_tracking_enabled = PUPPY_ALLOCATION_TRACKING;
+
+	/// @brief 割り当てを分類するサブシステム
+	/// @details 名前が同じカテゴリは同じカテゴリとして集計する
+	struct allocation_category final
+	{
+		/// @brief カテゴリの名前 (静的な寿命を持つ文字列)
+		const char* name = "general";
+	};
+
+#if PUPPY_ALLOCATION_TRACKING
+	namespace detail
+	{
+		/// @brief 割り当て元ごとの記録 (定義は実装側)
+		struct allocation_site;
+	}
+#endif
+
+	/// @brief 割り当てに付けるカテゴリと呼び出し元
+	/// @details allocation_tag{category} と書いた位置が呼び出し元として記録される。
+	///          割り当てのたびに呼び出し元を引くため、頻繁に割り当てる箇所ではPUPPY_ALLOCATION_TAGを使う
+	struct allocation_tag final
+	{
+		allocation_category category{};
+#if PUPPY_ALLOCATION_TRACKING
+		std::source_location location = std::source_location::current();
+		/// @brief 解決済みの割り当て元 (PUPPY_ALLOCATION_TAGが設定する)
+		const detail::allocation_site* site = nullptr;
+#endif
+	};
+}
+
+#if PUPPY_ALLOCATION_TRACKING
+namespace puppy::detail
+{
+	/// @brief タグに対応する割り当て元を引く
+	/// @details 割り当て元を記録できない場合はタグのない割り当ての割り当て元を返す
+	PUPPY_EXPORT const allocation_site* find_allocation_site(const allocation_tag& tag) noexcept;
+
+	/// @brief タグに対応する割り当て元を返す
+	PUPPY_FORCE_INLINE
+	const allocation_site* allocation_site_of(const allocation_tag& tag) noexcept
+	{
+		return tag.site != nullptr ? tag.site : find_allocation_site(tag);
+	}
+
+	/// @brief タグを指定しない割り当ての割り当て元を返す (allocation_scopeの中であればそのタグ)
+	PUPPY_EXPORT const allocation_site* current_allocation_site() noexcept;
+
+	/// @brief タグを指定しない割り当ての割り当て元を入れ替える
+	/// @return 以前の割り当て元
+	PUPPY_EXPORT const allocation_site* exchange_current_allocation_site(const allocation_site* site) noexcept;
+
+	PUPPY_EXPORT void record_allocation(const allocation_site* site, std::size_t bytes) noexcept;
+	PUPPY_EXPORT void record_deallocation(const allocation_site* site, std::size_t bytes) noexcept;
+
+	/// @brief scopeの解放を記録する
+	/// @details make_scope以外で生成したポインタ (site == nullptr) は割り当てが記録されていないため、
+	///          解放の時点でタグのない割り当てとして割り当てと解放を記録する
+	PUPPY_FORCE_INLINE
+	void record_scope_deallocation(const allocation_site* site, std::size_t bytes, std::size_t adopted_bytes) noexcept
+	{
+		if (site == nullptr) PUPPY_UNLIKELY
+		{
+			site = current_allocation_site();
+			bytes = adopted_bytes;
+			record_allocation(site, bytes);
+		}
+		record_deallocation(site, bytes);
+	}
+}
+#endif
+
+/// @brief 呼び出し元ごとに割り当て元を一度だけ解決するタグを生成する
+/// @param category 割り当てのカテゴリ (名前空間スコープの定数)
+#if PUPPY_ALLOCATION_TRACKING
+	#define PUPPY_ALLOCATION_TAG(category) \
+		([location = std::source_location::current()]() noexcept -> ::puppy::allocation_tag \
+		{ \
+			static const ::puppy::detail::allocation_site* const site = \
+				::puppy::detail::find_allocation_site(::puppy::allocation_tag{category, location}); \
+			return ::puppy::allocation_tag{category, location, site}; \
+		}())
+#else
+	#define PUPPY_ALLOCATION_TAG(category) (::puppy::allocation_tag{category})
+#endif
+
+namespace puppy
+{
+	/// @brief スコープの間、タグを指定しない割り当てを指定したカテゴリとして記録する
+	/// @details 呼び出し元にはこのオブジェクトを生成した位置が記録される
+	class allocation_scope final
+	{
+	public:
+		// --- コンストラクタ
+		PUPPY_NODISCARD_CTOR
+		explicit allocation_scope(
+			[[maybe_unused]] allocation_category category,
+			[[maybe_unused]] std::source_location location = std::source_location::current()) noexcept
+#if PUPPY_ALLOCATION_TRACKING
+			: _previous{detail::exchange_current_allocation_site(
+				detail::allocation_site_of(allocation_tag{category, location}))}
+#endif
+		{}
+
+		// --- デストラクタ
+		~allocation_scope()
+		{
+#if PUPPY_ALLOCATION_TRACKING
+			detail::exchange_current_allocation_site(_previous);
+#endif
+		}
+
+		// --- コピー / ムーブの禁止
+		allocation_scope(const allocation_scope&) = delete;
+		allocation_scope& operator=(const allocation_scope&) = delete;
+		allocation_scope(allocation_scope&&) = delete;
+		allocation_scope& operator=(allocation_scope&&) = delete;
+
+	private:
+#if PUPPY_ALLOCATION_TRACKING
+		// --- メンバ変数定義
+		const detail::allocation_site* _previous;
+#endif
+	};
+
+	/// @brief 割り当てを記録するアロケータ
+	/// @details 標準コンテナに渡すと、コンテナの割り当てもタグのカテゴリとして記録される。
+	///          追跡が無効の場合はstd::allocatorと同じ動作をする。
+	/// @tparam T 割り当てる型
+	template<class T>
+	class tracking_allocator
+	{
+	public:
+		// --- 型エイリアス定義
+		using value_type = T;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		// --- コンストラクタ
+
+		/// @brief タグを指定しない割り当てとして初期化する
+		PUPPY_NODISCARD_CTOR
+		tracking_allocator() noexcept
+#if PUPPY_ALLOCATION_TRACKING
+			: _site{detail::current_allocation_site()}
+#endif
+		{}
+
+		/// @brief タグを指定して初期化する
+		/// @param tag 割り当てのタグ
+		PUPPY_NODISCARD_CTOR
+		tracking_allocator([[maybe_unused]] const allocation_tag& tag) noexcept
+#if PUPPY_ALLOCATION_TRACKING
+			: _site{detail::allocation_site_of(tag)}
+#endif
+		{}
+
+		/// @brief 別の型のアロケータから初期化する
+		template<class U>
+		PUPPY_NODISCARD_CTOR
+		tracking_allocator([[maybe_unused]] const tracking_allocator<U>& other) noexcept
+#if PUPPY_ALLOCATION_TRACKING
+			: _site{other.site()}
+#endif
+		{}
+
+#if PUPPY_ALLOCATION_TRACKING
+		/// @brief 割り当て元を指定して初期化する
+		PUPPY_NODISCARD_CTOR
+		explicit tracking_allocator(const detail::allocation_site* site) noexcept
+			: _site{site}
+		{}
+#endif
+
+		// --- 操作メソッド
+		[[nodiscard]]
+		T* allocate(size_type count)
+		{
+			T* ptr = std::allocator<T>{}.allocate(count);
+#if PUPPY_ALLOCATION_TRACKING
+			detail::record_allocation(_site, count * sizeof(T));
+#endif
+			return ptr;
+		}
+
+		void deallocate(T* ptr, size_type count) noexcept
+		{
+#if PUPPY_ALLOCATION_TRACKING
+			detail::record_deallocation(_site, count * sizeof(T));
+#endif
+			std::allocator<T>{}.deallocate(ptr, count);
+		}
+
+		// --- ゲッターメソッド
+#if PUPPY_ALLOCATION_TRACKING
+		[[nodiscard]]
+		const detail::allocation_site* site() const noexcept
+		{
+			return _site;
+		}
+#endif
+
+		// --- 演算子オーバーロード
+
+		/// @brief 記録先が同じアロケータであれば等しい
+		template<class U>
+		[[nodiscard]]
+		bool operator==([[maybe_unused]] const tracking_allocator<U>& other) const noexcept
+		{
+#if PUPPY_ALLOCATION_TRACKING
+			return _site == other.site();
+#else
+			return true;
+#endif
+		}
+
+	private:
+#if PUPPY_ALLOCATION_TRACKING
+		// --- メンバ変数定義
+		const detail::allocation_site* _site;
+#endif
+	};
+
+#if PUPPY_ALLOCATION_TRACKING
+	/// @brief 解放を記録するscopeのデリータ
+	/// @tparam T 解放する型
+	template<class T>
+	struct tracking_deleter final
+	{
+		PUPPY_NODISCARD_CTOR
+		constexpr tracking_deleter() noexcept = default;
+
+		PUPPY_NODISCARD_CTOR
+		constexpr tracking_deleter(const detail::allocation_site* site, std::size_t bytes) noexcept
+			: site{site}, bytes{bytes}
+		{}
+
+		/// @brief 派生クラスのデリータから変換する (割り当てたバイト数を引き継ぐ)
+		template<class U>
+		requires std::is_convertible_v<U*, T*>
+		PUPPY_NODISCARD_CTOR
+		constexpr tracking_deleter(const tracking_deleter<U>& other) noexcept
+			: site{other.site}, bytes{other.bytes}
+		{}
+
+		/// @brief std::unique_ptrのデリータから変換する
+		/// @details 追跡の有無に関わらず、std::unique_ptrからscopeへ所有権を移せる
+		template<class U>
+		requires std::is_convertible_v<U*, T*>
+		PUPPY_NODISCARD_CTOR
+		constexpr tracking_deleter(const std::default_delete<U>&) noexcept
+		{}
+
+		void operator()(T* ptr) const noexcept
+		{
+			static_assert(sizeof(T) > 0, "Cannot delete an incomplete type.");
+			delete ptr;
+			detail::record_scope_deallocation(site, bytes, sizeof(T));
+		}
+
+		const detail::allocation_site* site = nullptr;
+		std::size_t bytes = 0;
+	};
+
+	/// @brief 解放を記録するscopeのデリータ (配列)
+	template<class T>
+	struct tracking_deleter<T[]> final
+	{
+		PUPPY_NODISCARD_CTOR
+		constexpr tracking_deleter() noexcept = default;
+
+		PUPPY_NODISCARD_CTOR
+		constexpr tracking_deleter(const detail::allocation_site* site, std::size_t bytes) noexcept
+			: site{site}, bytes{bytes}
+		{}
+
+		/// @brief std::unique_ptrのデリータから変換する (要素数が分からないため、バイト数は0として記録する)
+		PUPPY_NODISCARD_CTOR
+		constexpr tracking_deleter(const std::default_delete<T[]>&) noexcept
+		{}
+
+		void operator()(T* ptr) const noexcept
+		{
+			static_assert(sizeof(T) > 0, "Cannot delete an incomplete type.");
+			delete[] ptr;
+			detail::record_scope_deallocation(site, bytes, 0);
+		}
+
+		const detail::allocation_site* site = nullptr;
+		std::size_t bytes = 0;
+	};
+#endif
+}
+
+#endif // _PUPPY_ALLOCATION_HPP
@@ -0,0 +1,158 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#ifndef _PUPPY_ALLOCATION_TRACKER_HPP
+#define _PUPPY_ALLOCATION_TRACKER_HPP
+
+#include "common.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace puppy
+{
+	/// @brief 割り当ての統計情報
+	struct allocation_stats final
+	{
+		/// @brief 割り当ての回数
+		std::uint64_t allocations = 0;
+		/// @brief 解放の回数
+		std::uint64_t deallocations = 0;
+		/// @brief 割り当てたバイト数の合計
+		std::uint64_t allocated_bytes = 0;
+		/// @brief 解放したバイト数の合計
+		std::uint64_t freed_bytes = 0;
+		/// @brief 解放されていないバイト数 (差分の場合は増減)
+		std::int64_t live_bytes = 0;
+		/// @brief 標本化した解放されていないバイト数の最大値 (差分では0)
+		/// @details 真のピークではない。割り当てのたびには更新せず、captureとsample_peaksの呼び出し時に観測した
+		///          live_bytesの最大値になるため、呼び出しの間の一時的な増加は含まれない
+		std::int64_t sampled_peak_bytes = 0;
+
+		/// @brief 解放されていない割り当ての数を返す (差分の場合は増減)
+		[[nodiscard]]
+		constexpr std::int64_t live_count() const noexcept
+		{
+			return static_cast<std::int64_t>(allocations) - static_cast<std::int64_t>(deallocations);
+		}
+	};
+
+	/// @brief カテゴリまたは呼び出し元ごとの割り当ての記録
+	struct allocation_record final
+	{
+		/// @brief スナップショット間で記録を対応付ける識別子
+		size_t id = 0;
+		/// @brief カテゴリの名前
+		std::string category;
+		/// @brief 呼び出し元のファイル名 (カテゴリの記録とタグのない割り当ては空)
+		std::string file;
+		/// @brief 呼び出し元の関数名
+		std::string function;
+		/// @brief 呼び出し元の行番号
+		std::uint32_t line = 0;
+		/// @brief 呼び出し元の列番号
+		std::uint32_t column = 0;
+		/// @brief 統計情報
+		allocation_stats stats;
+	};
+
+	/// @brief ある時点の割り当ての記録
+	/// @details 追跡が無効の場合は常に空になる
+	class PUPPY_EXPORT allocation_snapshot final
+	{
+	public:
+		// --- 型エイリアス定義
+		using clock = std::chrono::steady_clock;
+
+		// --- コンストラクタ
+		PUPPY_NODISCARD_CTOR
+		allocation_snapshot() noexcept = default;
+
+		// --- 操作メソッド
+
+		/// @brief 現在の割り当ての記録を取得する
+		/// @details 各スレッドのカウンタを集計する。割り当てと並行して呼び出せる
+		[[nodiscard]]
+		static allocation_snapshot capture();
+
+		/// @brief sampled_peak_bytesを標本化する
+		/// @details 記録を作らずに集計だけ行う。フレームごとなど定期的に呼び出すほど標本化したピークが真のピークに近づく
+		static void sample_peaks();
+
+		/// @brief 以前のスナップショットからの差分を返す
+		/// @details 回数とバイト数は差を取る。2つの時点の間のピークは分からないため、ピークは0になる
+		/// @param earlier 以前に取得したスナップショット
+		[[nodiscard]]
+		allocation_snapshot diff(const allocation_snapshot& earlier) const;
+
+		/// @brief 記録を表形式で出力する (解放されていないバイト数の多い順)
+		/// @param stream 出力先
+		void dump(std::ostream& stream) const;
+
+		// --- ゲッターメソッド
+
+		/// @brief 取得した時刻を返す
+		[[nodiscard]]
+		clock::time_point time() const noexcept
+		{
+			return _time;
+		}
+
+		/// @brief 記録の対象期間を返す (追跡の開始または差分の基準からの経過時間)
+		[[nodiscard]]
+		clock::duration duration() const noexcept
+		{
+			return _duration;
+		}
+
+		/// @brief 呼び出し元ごとの記録を返す
+		[[nodiscard]]
+		const std::vector<allocation_record>& sites() const noexcept
+		{
+			return _sites;
+		}
+
+		/// @brief カテゴリごとの記録を返す
+		[[nodiscard]]
+		const std::vector<allocation_record>& categories() const noexcept
+		{
+			return _categories;
+		}
+
+		/// @brief カテゴリの記録を返す
+		/// @param name カテゴリの名前
+		/// @return カテゴリの記録、割り当てがなければnullptr
+		[[nodiscard]]
+		const allocation_record* category(std::string_view name) const noexcept;
+
+		/// @brief 全ての割り当ての統計情報を返す
+		[[nodiscard]]
+		allocation_stats total() const noexcept;
+
+		/// @brief 対象期間の1秒あたりの割り当て回数を返す
+		/// @param record このスナップショットの記録
+		[[nodiscard]]
+		double allocation_rate(const allocation_record& record) const noexcept;
+
+	private:
+		// --- メンバ変数定義
+		clock::time_point _time{};
+		clock::duration _duration{};
+		std::vector<allocation_record> _sites;
+		std::vector<allocation_record> _categories;
+		allocation_stats _total;
+		bool _difference = false;
+	};
+}
+
+#endif // _PUPPY_ALLOCATION_TRACKER_HPP
@@ -0,0 +1,293 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#ifndef _PUPPY_ASSET_CACHE_HPP
+#define _PUPPY_ASSET_CACHE_HPP
+
+#include "common.hpp"
+#include "string_view.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <limits>
+#include <typeindex>
+#include <typeinfo>
+
+namespace puppy
+{
+	/// @brief 予算を制限しないことを表す値
+	inline constexpr size_t asset_cache_unlimited = std::numeric_limits<size_t>::max();
+
+	/// @brief ローダーが読み込んだアセット
+	/// @tparam T アセットの型
+	template<class T>
+	struct asset_data final
+	{
+		/// @brief 読み込んだアセット (失敗した場合はnullptr)
+		ref<T> value;
+		/// @brief 予算の計算に使うアセットのバイト数
+		size_t bytes = 0;
+	};
+
+	/// @brief ファイルからアセットを読み込む関数
+	/// @details バックグラウンドのスレッドで呼び出される。失敗した場合は空のアセットを返すこと
+	///          (例外を送出した場合も失敗として扱う)
+	template<class T>
+	using asset_loader = std::function<asset_data<T>(const std::filesystem::path&)>;
+
+	/// @brief キャッシュの設定
+	struct asset_cache_options final
+	{
+		/// @brief 全ての型で共有するバイト数の予算
+		size_t budget = asset_cache_unlimited;
+		/// @brief ローダーを実行するスレッド数 (0の場合はハードウェアのスレッド数)
+		size_t thread_count = 0;
+		/// @brief ファイルの変更を監視してエントリを無効化するか (Linuxのみ)
+		bool hot_reload = true;
+	};
+
+	/// @brief キャッシュの統計情報
+	struct asset_cache_stats final
+	{
+		/// @brief 読み込み時間のヒストグラムの区間数
+		static constexpr size_t latency_bucket_count = 32;
+
+		/// @brief 読み込み済みのエントリを返した回数
+		std::uint64_t hits = 0;
+		/// @brief 読み込み中のエントリに合流した回数
+		std::uint64_t merged = 0;
+		/// @brief 新しく読み込みを開始した回数
+		std::uint64_t misses = 0;
+		/// @brief ローダーが失敗した回数
+		std::uint64_t failures = 0;
+		/// @brief 予算を超えたために追い出したエントリの数
+		std::uint64_t evictions = 0;
+		/// @brief ファイルの変更によって無効化したエントリの数
+		std::uint64_t reloads = 0;
+		/// @brief キャッシュが保持しているバイト数
+		size_t resident_bytes = 0;
+		/// @brief キャッシュが保持しているエントリの数
+		size_t resident_count = 0;
+		/// @brief バイト数の予算
+		size_t budget = asset_cache_unlimited;
+		/// @brief 読み込み時間のヒストグラム
+		/// @details 区間iは[2^i, 2^(i+1))マイクロ秒の読み込みの回数 (区間0は1マイクロ秒未満を含む)
+		std::array<std::uint64_t, latency_bucket_count> load_latency{};
+
+		/// @brief 読み込みを開始せずに応えた要求の割合を返す
+		[[nodiscard]]
+		constexpr double hit_rate() const noexcept
+		{
+			const std::uint64_t requests = hits + merged + misses;
+			return requests == 0 ? 0.0 : static_cast<double>(hits + merged) / static_cast<double>(requests);
+		}
+
+		/// @brief 読み込み時間のパーセンタイルの上限を返す
+		/// @param percentile 0から1の範囲の割合
+		/// @return 指定した割合の読み込みが収まる区間の上限
+		[[nodiscard]]
+		constexpr std::chrono::microseconds latency_percentile(double percentile) const noexcept
+		{
+			std::uint64_t total = 0;
+			for (const auto count : load_latency)
+			{
+				total += count;
+			}
+
+			const auto target = static_cast<double>(total) * percentile;
+			std::uint64_t accumulated = 0;
+			for (size_t i = 0; i < latency_bucket_count; ++i)
+			{
+				accumulated += load_latency[i];
+				if (accumulated != 0 && static_cast<double>(accumulated) >= target)
+				{
+					return std::chrono::microseconds{std::int64_t{1} << (i + 1)};
+				}
+			}
+			return std::chrono::microseconds{0};
+		}
+	};
+
+	/// @brief 読み込み中のアセットへのハンドル
+	/// @tparam T アセットの型
+	template<class T>
+	class asset_future final
+	{
+	public:
+		// --- コンストラクタ
+		PUPPY_NODISCARD_CTOR
+		asset_future() noexcept = default;
+
+		PUPPY_NODISCARD_CTOR
+		explicit asset_future(std::shared_future<ref<void>> future) noexcept
+			: _future{std::move(future)}
+		{}
+
+		// --- ゲッターメソッド
+
+		/// @brief 有効なハンドルであるかを返す
+		[[nodiscard]]
+		bool valid() const noexcept
+		{
+			return _future.valid();
+		}
+
+		/// @brief 読み込みが完了しているかを返す
+		[[nodiscard]]
+		bool ready() const
+		{
+			return _future.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+		}
+
+		/// @brief 読み込みの完了を待つ
+		void wait() const
+		{
+			_future.wait();
+		}
+
+		/// @brief 読み込みの完了を待ってアセットを返す
+		/// @return 読み込んだアセット、失敗した場合はnullptr
+		[[nodiscard]]
+		ref<T> get() const
+		{
+			return std::static_pointer_cast<T>(_future.get());
+		}
+
+	private:
+		// --- メンバ変数定義
+		std::shared_future<ref<void>> _future;
+	};
+
+	/// @brief パスをキーにしてアセットを共有するキャッシュ
+	/// @details 同じパスと型への同時の要求は1回の読み込みにまとめられ、ローダーはバックグラウンドのスレッドで実行される。
+	///          全体と型ごとのバイト数の予算を超えると、最も長く使われていないエントリから追い出す。
+	///          キャッシュの外で参照されているエントリは追い出しても解放されないため対象から外す。
+	class PUPPY_EXPORT asset_cache final
+	{
+	public:
+		// --- コンストラクタ
+
+		/// @brief 設定を指定して初期化する
+		/// @param options キャッシュの設定
+		PUPPY_NODISCARD_CTOR
+		explicit asset_cache(const asset_cache_options& options = {});
+
+		// --- デストラクタ
+
+		/// @brief 実行中の読み込みの完了を待ってから破棄する
+		~asset_cache();
+
+		// --- コピー / ムーブの禁止
+		PUPPY_NOT_COPYABLE(asset_cache);
+		PUPPY_NOT_MOVEABLE(asset_cache);
+
+		// --- 操作メソッド
+
+		/// @brief 型のローダーを登録する
+		/// @tparam T アセットの型
+		/// @param loader ローダー
+		/// @param budget この型のエントリが保持できるバイト数の予算
+		template<class T>
+		void register_loader(asset_loader<T> loader, size_t budget = asset_cache_unlimited)
+		{
+			register_loader(typeid(T), [loader = std::move(loader)](const std::filesystem::path& path)
+			{
+				auto data = loader(path);
+				return asset_data<void>{std::move(data.value), data.bytes};
+			}, budget);
+		}
+
+		/// @brief アセットを取得する (読み込み済みでなければ読み込みの完了を待つ)
+		/// @tparam T アセットの型
+		/// @param path アセットのパス
+		/// @return アセット、読み込みに失敗した場合はnullptr
+		template<class T>
+		[[nodiscard]]
+		ref<T> get(string_view path)
+		{
+			return std::static_pointer_cast<T>(acquire(typeid(T), path));
+		}
+
+		/// @brief アセットの読み込みを開始する
+		/// @tparam T アセットの型
+		/// @param path アセットのパス
+		/// @return 読み込み中のアセットへのハンドル
+		template<class T>
+		[[nodiscard]]
+		asset_future<T> load(string_view path)
+		{
+			return asset_future<T>{acquire_async(typeid(T), path)};
+		}
+
+		/// @brief 読み込み済みのアセットを返す (読み込みは開始しない)
+		/// @tparam T アセットの型
+		/// @param path アセットのパス
+		/// @return アセット、読み込み済みでなければnullptr
+		template<class T>
+		[[nodiscard]]
+		ref<T> find(string_view path)
+		{
+			return std::static_pointer_cast<T>(find(typeid(T), path));
+		}
+
+		/// @brief 全ての型のパスに一致するエントリを無効化する
+		/// @param path アセットのパス
+		void invalidate(string_view path);
+
+		/// @brief 全てのエントリを無効化する
+		void clear();
+
+		/// @brief 全体のバイト数の予算を設定する
+		/// @param bytes バイト数の予算
+		void set_budget(size_t bytes);
+
+		/// @brief 型のバイト数の予算を設定する
+		/// @tparam T アセットの型
+		/// @param bytes バイト数の予算
+		template<class T>
+		void set_budget(size_t bytes)
+		{
+			set_budget(typeid(T), bytes);
+		}
+
+		// --- ゲッターメソッド
+
+		/// @brief 全体の統計情報を返す
+		[[nodiscard]]
+		asset_cache_stats stats() const;
+
+		/// @brief 型の統計情報を返す
+		/// @tparam T アセットの型
+		template<class T>
+		[[nodiscard]]
+		asset_cache_stats stats() const
+		{
+			return stats(typeid(T));
+		}
+
+	private:
+		// --- 内部メソッド
+		void register_loader(std::type_index type, asset_loader<void> loader, size_t budget);
+		ref<void> acquire(std::type_index type, string_view path);
+		std::shared_future<ref<void>> acquire_async(std::type_index type, string_view path);
+		ref<void> find(std::type_index type, string_view path);
+		void set_budget(std::type_index type, size_t bytes);
+		asset_cache_stats stats(std::type_index type) const;
+
+		// --- メンバ変数定義
+		struct impl;
+		scope<impl> _impl;
+	};
+}
+
+#endif // _PUPPY_ASSET_CACHE_HPP
@@ -0,0 +1,69 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#ifndef _PUPPY_FIXED_STRING_HPP
+#define _PUPPY_FIXED_STRING_HPP
+
+#include "common.hpp"
+#include "string_view.hpp"
+#include <algorithm>
+
+namespace puppy
+{
+	/// @brief テンプレート引数として渡せる固定長の文字列
+	/// @tparam TChar 文字列の文字型
+	/// @tparam N ヌル文字を含む文字列の長さ
+	template<class TChar, size_t N>
+	struct fixed_string final
+	{
+		// --- 型エイリアス定義
+		using value_type = TChar;
+		using size_type  = size_t;
+
+		// --- コンストラクタ
+
+		/// @brief 文字列リテラルから初期化する
+		/// @param str 文字列リテラル
+		PUPPY_NODISCARD_CTOR
+		constexpr fixed_string(const TChar (&str)[N]) noexcept
+		{
+			std::copy_n(str, N, data);
+		}
+
+		// --- ゲッターメソッド
+
+		/// @brief 文字列の長さを返す
+		/// @return ヌル文字を含まない文字列の長さ
+		[[nodiscard]]
+		constexpr size_type size() const noexcept
+		{
+			return N - 1;
+		}
+
+		/// @brief 文字列を参照するbasic_string_viewを返す
+		/// @return 文字列を参照するbasic_string_view
+		[[nodiscard]]
+		constexpr basic_string_view<TChar> view() const noexcept
+		{
+			return {data, N - 1};
+		}
+
+		// --- メンバ変数定義
+
+		/// @brief 文字列 (構造的型とするため公開する)
+		TChar data[N]{};
+	};
+
+	// --- 導入子定義
+	template<class TChar, size_t N>
+	fixed_string(const TChar (&)[N]) -> fixed_string<TChar, N>;
+}
+
+#endif // _PUPPY_FIXED_STRING_HPP
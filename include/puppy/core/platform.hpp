@@ -37,22 +37,35 @@
 	#error Unsupported platform.
 #endif
 
+// --- アーキテクチャ
+#define PUPPY_ARCHITECTURE_X86          0
+#define PUPPY_ARCHITECTURE_ARM          0
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#undef  PUPPY_ARCHITECTURE_X86
+	#define PUPPY_ARCHITECTURE_X86      1
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__arm__) || defined(_M_ARM)
+	#undef  PUPPY_ARCHITECTURE_ARM
+	#define PUPPY_ARCHITECTURE_ARM      1
+#endif
+
 // --- 命令セット
+// コンパイラが対象の命令セットを有効にしている場合のみ1になる (x86以外では常に0)
+// MSVCはSSE4を示すマクロを定義しないため、/arch:AVX以上であることで判定する
+#define PUPPY_INTRINSIC_SSE2            0
+#define PUPPY_INTRINSIC_SSE4_1          0
 #define PUPPY_INTRINSIC_SSE             0
 
-#if PUPPY_PLATFORM_WINDOWS
-	#undef  PUPPY_INTRINSIC_SSE
-	#define PUPPY_INTRINSIC_SSE         1
-#elif PUPPY_PLATFORM_MACOS
-	#undef  PUPPY_INTRINSIC_SSE
-	#define PUPPY_INTRINSIC_SSE         1
-#elif PUPPY_PLATFORM_LINUX
-	#if defined(__SSE_4_2__) && __SSSE_4_2__
-		#undef  PUPPY_INTRINSIC_SSE
-		#define PUPPY_INTRINSIC_SSE     1
+#if PUPPY_ARCHITECTURE_X86
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#undef  PUPPY_INTRINSIC_SSE2
+		#define PUPPY_INTRINSIC_SSE2    1
+	#endif
+	#if defined(__SSE4_1__) || defined(__AVX__)
+		#undef  PUPPY_INTRINSIC_SSE4_1
+		#define PUPPY_INTRINSIC_SSE4_1  1
 	#endif
-#elif PUPPY_PLATFORM_WEB
-	#if defined(__SSE_4_2__) && __SSSE_4_2__
+	#if defined(__SSE4_2__) || defined(__AVX__)
 		#undef  PUPPY_INTRINSIC_SSE
 		#define PUPPY_INTRINSIC_SSE     1
 	#endif
@@ -0,0 +1,222 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#ifndef _PUPPY_REFLECTION_HPP
+#define _PUPPY_REFLECTION_HPP
+
+#include "common.hpp"
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// @brief 型のメンバを記述し、コンパイル時リフレクションを有効にする
+/// @param type_name 型の名前
+/// @param ... 記述するメンバ変数の名前
+/// @details クラス定義の中に記述する。スキーマのバージョンは1になる
+#define PUPPY_REFLECT(type_name, ...) \
+	PUPPY_REFLECT_VERSIONED(type_name, 1, __VA_ARGS__)
+
+/// @brief スキーマのバージョンを指定して型のメンバを記述する
+/// @param type_name 型の名前
+/// @param version_number スキーマのバージョン
+/// @param ... 記述するメンバ変数の名前
+/// @details メンバの並び順がフィールドIDになるため、
+///          既存のメンバの順序を変えずに末尾へ追加すること
+#define PUPPY_REFLECT_VERSIONED(type_name, version_number, ...)                     \
+	friend constexpr auto _puppy_describe(const type_name*) noexcept               \
+	{                                                                               \
+		using _puppy_reflected_type = type_name;                                    \
+		return ::puppy::detail::make_type_descriptor<type_name, (version_number)>(  \
+			#type_name                                                              \
+			_PUPPY_FOR_EACH(_PUPPY_REFLECT_FIELD, __VA_ARGS__));                    \
+	}
+
+#define _PUPPY_REFLECT_FIELD(member) \
+	, ::puppy::detail::make_field_descriptor(#member, &_puppy_reflected_type::member)
+
+// --- 可変長引数の展開 (最大32個)
+#define _PUPPY_FOR_EACH(macro, ...) \
+	_PUPPY_FOR_EACH_N(__VA_ARGS__, _PUPPY_FOR_EACH_SEQ)(macro, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_N(...) _PUPPY_FOR_EACH_ARG(__VA_ARGS__)
+#define _PUPPY_FOR_EACH_ARG(                                                        \
+	_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16,          \
+	_17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, \
+	N, ...) _PUPPY_FOR_EACH_##N
+#define _PUPPY_FOR_EACH_SEQ                                                         \
+	32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,                 \
+	16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1
+#define _PUPPY_FOR_EACH_1(m, x)       m(x)
+#define _PUPPY_FOR_EACH_2(m, x, ...)  m(x) _PUPPY_FOR_EACH_1(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_3(m, x, ...)  m(x) _PUPPY_FOR_EACH_2(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_4(m, x, ...)  m(x) _PUPPY_FOR_EACH_3(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_5(m, x, ...)  m(x) _PUPPY_FOR_EACH_4(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_6(m, x, ...)  m(x) _PUPPY_FOR_EACH_5(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_7(m, x, ...)  m(x) _PUPPY_FOR_EACH_6(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_8(m, x, ...)  m(x) _PUPPY_FOR_EACH_7(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_9(m, x, ...)  m(x) _PUPPY_FOR_EACH_8(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_10(m, x, ...) m(x) _PUPPY_FOR_EACH_9(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_11(m, x, ...) m(x) _PUPPY_FOR_EACH_10(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_12(m, x, ...) m(x) _PUPPY_FOR_EACH_11(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_13(m, x, ...) m(x) _PUPPY_FOR_EACH_12(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_14(m, x, ...) m(x) _PUPPY_FOR_EACH_13(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_15(m, x, ...) m(x) _PUPPY_FOR_EACH_14(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_16(m, x, ...) m(x) _PUPPY_FOR_EACH_15(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_17(m, x, ...) m(x) _PUPPY_FOR_EACH_16(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_18(m, x, ...) m(x) _PUPPY_FOR_EACH_17(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_19(m, x, ...) m(x) _PUPPY_FOR_EACH_18(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_20(m, x, ...) m(x) _PUPPY_FOR_EACH_19(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_21(m, x, ...) m(x) _PUPPY_FOR_EACH_20(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_22(m, x, ...) m(x) _PUPPY_FOR_EACH_21(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_23(m, x, ...) m(x) _PUPPY_FOR_EACH_22(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_24(m, x, ...) m(x) _PUPPY_FOR_EACH_23(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_25(m, x, ...) m(x) _PUPPY_FOR_EACH_24(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_26(m, x, ...) m(x) _PUPPY_FOR_EACH_25(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_27(m, x, ...) m(x) _PUPPY_FOR_EACH_26(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_28(m, x, ...) m(x) _PUPPY_FOR_EACH_27(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_29(m, x, ...) m(x) _PUPPY_FOR_EACH_28(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_30(m, x, ...) m(x) _PUPPY_FOR_EACH_29(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_31(m, x, ...) m(x) _PUPPY_FOR_EACH_30(m, __VA_ARGS__)
+#define _PUPPY_FOR_EACH_32(m, x, ...) m(x) _PUPPY_FOR_EACH_31(m, __VA_ARGS__)
+
+namespace puppy::detail
+{
+	template<class T, auto Member, size_t... Indices>
+	consteval size_t find_field(std::index_sequence<Indices...>) noexcept;
+}
+
+namespace puppy
+{
+	/// @brief メンバ変数の記述子
+	/// @tparam TClass メンバを持つ型
+	/// @tparam TMember メンバの型
+	template<class TClass, class TMember>
+	struct field_descriptor final
+	{
+		// --- 型エイリアス定義
+		using class_type  = TClass;
+		using member_type = TMember;
+
+		/// @brief メンバの名前
+		const char* name;
+		/// @brief メンバへのポインタ
+		TMember TClass::* pointer;
+	};
+
+	/// @brief 型の記述子
+	/// @tparam TClass 記述する型
+	/// @tparam Version スキーマのバージョン
+	/// @tparam TFields メンバの記述子の型
+	template<class TClass, std::uint32_t Version, class... TFields>
+	struct type_descriptor final
+	{
+		// --- 型エイリアス定義
+		using class_type = TClass;
+
+		// --- 定数定義
+
+		/// @brief スキーマのバージョン
+		static constexpr std::uint32_t version = Version;
+		/// @brief メンバの数
+		static constexpr size_t field_count = sizeof...(TFields);
+
+		/// @brief 型の名前
+		const char* name;
+		/// @brief メンバの記述子
+		std::tuple<TFields...> fields;
+	};
+
+	/// @brief PUPPY_REFLECTで記述された型であるか
+	template<class T>
+	concept reflectable = requires
+	{
+		_puppy_describe(static_cast<const std::remove_cv_t<T>*>(nullptr));
+	};
+
+	/// @brief 型の記述子を返す
+	/// @tparam T 記述された型
+	/// @return 型の記述子
+	template<reflectable T>
+	[[nodiscard]]
+	PUPPY_FORCE_INLINE
+	constexpr auto describe() noexcept
+	{
+		return _puppy_describe(static_cast<const std::remove_cv_t<T>*>(nullptr));
+	}
+
+	/// @brief 型の記述子
+	template<reflectable T>
+	inline constexpr auto descriptor_v = describe<T>();
+
+	/// @brief 記述されたすべてのメンバに対して関数を呼び出す
+	/// @param func 呼び出す関数 (記述子、メンバへの参照、フィールドID) を受け取る
+	template<reflectable T, class TFunc>
+	constexpr void for_each_field(T& object, TFunc&& func)
+	{
+		constexpr auto& descriptor = descriptor_v<std::remove_cv_t<T>>;
+		[&]<size_t... Indices>(std::index_sequence<Indices...>)
+		{
+			(func(std::get<Indices>(descriptor.fields),
+				object.*(std::get<Indices>(descriptor.fields).pointer),
+				std::integral_constant<size_t, Indices>{}), ...);
+		}(std::make_index_sequence<descriptor.field_count>{});
+	}
+
+	/// @brief メンバへのポインタからフィールドIDを返す
+	/// @tparam T 記述された型
+	/// @tparam Member メンバへのポインタ
+	/// @return フィールドID
+	template<reflectable T, auto Member>
+	[[nodiscard]]
+	consteval size_t field_index() noexcept
+	{
+		return detail::find_field<T, Member>(
+			std::make_index_sequence<descriptor_v<T>.field_count>{});
+	}
+}
+
+namespace puppy::detail
+{
+	template<class TClass, class TMember>
+	constexpr auto make_field_descriptor(const char* name, TMember TClass::* pointer) noexcept
+	{
+		return field_descriptor<TClass, TMember>{name, pointer};
+	}
+
+	template<class TClass, std::uint32_t Version, class... TFields>
+	constexpr auto make_type_descriptor(const char* name, TFields... fields) noexcept
+	{
+		return type_descriptor<TClass, Version, TFields...>{name, {fields...}};
+	}
+
+	template<class T, auto Member, size_t Index>
+	consteval bool is_field() noexcept
+	{
+		constexpr auto& field = std::get<Index>(descriptor_v<T>.fields);
+		if constexpr (std::is_same_v<decltype(field.pointer), decltype(Member)>)
+		{
+			return field.pointer == Member;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	template<class T, auto Member, size_t... Indices>
+	consteval size_t find_field(std::index_sequence<Indices...>) noexcept
+	{
+		size_t result = sizeof...(Indices);
+		((is_field<T, Member, Indices>() ? (result = Indices, true) : false) || ...);
+		return result;
+	}
+}
+
+#endif // _PUPPY_REFLECTION_HPP
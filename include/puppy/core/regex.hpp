@@ -0,0 +1,1971 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#ifndef _PUPPY_REGEX_HPP
+#define _PUPPY_REGEX_HPP
+
+#include "common.hpp"
+#include "contracts.hpp"
+#include "fixed_string.hpp"
+#include "string_view.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if PUPPY_INTRINSIC_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace puppy
+{
+	/// @brief 正規表現の構文エラーの種類
+	enum class regex_error : std::uint8_t
+	{
+		none,                   ///< エラーなし
+		unexpected_end,         ///< パターンが途中で終了している
+		unmatched_parenthesis,  ///< 括弧の対応が取れていない
+		nothing_to_repeat,      ///< 繰り返しの対象が存在しない
+		invalid_escape,         ///< 不正なエスケープシーケンス
+		invalid_class,          ///< 不正な文字クラス
+		invalid_repeat,         ///< 不正な繰り返し回数
+		unsupported,            ///< 対応していない構文 (先読み、後方参照など)
+		too_complex,            ///< 展開後のプログラムが大きすぎる
+	};
+}
+
+namespace puppy::detail
+{
+	/// @brief 文字の値を符号なしのコードポイントとして返す
+	template<class TChar>
+	[[nodiscard]]
+	PUPPY_FORCE_INLINE
+	constexpr char32_t regex_code(TChar c) noexcept
+	{
+		if constexpr (std::is_same_v<TChar, char>)
+		{
+			return static_cast<unsigned char>(c);
+		}
+		else
+		{
+			return static_cast<char32_t>(c);
+		}
+	}
+
+	/// @brief 単語を構成する文字であるか (\w, \b の判定に使う)
+	[[nodiscard]]
+	PUPPY_FORCE_INLINE
+	constexpr bool regex_is_word(char32_t c) noexcept
+	{
+		return (c >= U'0' && c <= U'9') || (c >= U'A' && c <= U'Z')
+			|| (c >= U'a' && c <= U'z') || c == U'_';
+	}
+
+	// --- コンパイル済みプログラム
+
+	/// @brief 命令の種類
+	enum class regex_op : std::uint8_t
+	{
+		character,          ///< value と一致する1文字を消費する
+		char_class,         ///< 文字クラス x に含まれる1文字を消費する
+		split,              ///< x を優先して x と y に分岐する
+		jump,               ///< x へ移動する
+		save,               ///< 現在位置をキャプチャスロット x に記録する
+		assert_begin,       ///< 文字列の先頭
+		assert_end,         ///< 文字列の末尾
+		word_boundary,      ///< 単語境界
+		not_word_boundary,  ///< 単語境界以外
+		match,              ///< マッチ成功
+	};
+
+	struct regex_instruction final
+	{
+		regex_op op = regex_op::match;
+		char32_t value = 0;
+		std::uint32_t x = 0;
+		std::uint32_t y = 0;
+	};
+
+	struct regex_range final
+	{
+		char32_t first = 0;
+		char32_t last = 0;
+	};
+
+	/// @brief 正規化済みの文字範囲の集合 (否定は構築時に補集合へ変換する)
+	struct regex_class final
+	{
+		std::uint32_t first = 0;
+		std::uint32_t count = 0;
+		std::uint64_t ascii[2]{};
+	};
+
+	/// @brief DFAの状態の属性
+	enum regex_state_flags : std::uint8_t
+	{
+		regex_state_accepting = 1 << 0,  ///< この位置でマッチが成立する
+		regex_state_accepting_at_end = 1 << 1,  ///< 文字列の末尾であればマッチが成立する
+	};
+
+	inline constexpr std::uint32_t regex_unbounded = UINT32_MAX;
+	inline constexpr std::uint32_t regex_repeat_limit = 1000;
+	inline constexpr size_t regex_program_limit = 1 << 14;
+	inline constexpr size_t regex_prefix_limit = 16;
+
+	// Pike VMのスレッドリストと作業スタックがこの大きさを超える場合はスタックではなくヒープに置く
+	inline constexpr size_t regex_stack_limit = 4096;
+
+	// DFAの構築はコンパイル時の計算量を抑えるため、小さなパターンに限定する
+	inline constexpr size_t regex_dfa_program_limit = 128;
+	inline constexpr size_t regex_dfa_class_limit = 64;
+	inline constexpr size_t regex_dfa_state_limit = 64;
+
+	/// @brief コンパイル時にのみ使う可変長の中間表現
+	struct regex_compiled final
+	{
+		struct dfa final
+		{
+			std::vector<std::uint8_t> transitions;
+			std::vector<std::uint8_t> flags;
+		};
+
+		regex_error error = regex_error::none;
+		size_t error_position = 0;
+		size_t capture_count = 1;
+		bool anchored = false;
+		std::vector<regex_instruction> program;
+		std::vector<regex_range> ranges;
+		std::vector<regex_class> classes;
+		std::vector<char32_t> prefix;
+		std::vector<char32_t> dfa_boundaries;
+		dfa match_dfa;
+		dfa search_dfa;
+	};
+
+	// --- 構文解析
+
+	enum class regex_node_kind : std::uint8_t
+	{
+		empty,
+		literal,
+		char_class,
+		concat,
+		alternate,
+		repeat,
+		capture,
+		assert_begin,
+		assert_end,
+		word_boundary,
+		not_word_boundary,
+	};
+
+	struct regex_node final
+	{
+		regex_node_kind kind = regex_node_kind::empty;
+		char32_t value = 0;
+		std::uint32_t left = 0;
+		std::uint32_t right = 0;
+		std::uint32_t min = 0;
+		std::uint32_t max = 0;
+		bool lazy = false;
+	};
+
+	/// @brief 範囲を並べ替えて、重複や隣接する範囲を結合する
+	constexpr void regex_normalize(std::vector<regex_range>& ranges)
+	{
+		std::sort(ranges.begin(), ranges.end(), [](const regex_range& lhs, const regex_range& rhs)
+		{
+			return lhs.first < rhs.first;
+		});
+
+		size_t count = 0;
+		for (const auto& range : ranges)
+		{
+			if (count != 0 && std::uint64_t{range.first} <= std::uint64_t{ranges[count - 1].last} + 1)
+			{
+				ranges[count - 1].last = std::max(ranges[count - 1].last, range.last);
+			}
+			else
+			{
+				ranges[count++] = range;
+			}
+		}
+		ranges.resize(count);
+	}
+
+	/// @brief 正規化済みの範囲の補集合を返す
+	constexpr void regex_complement(std::vector<regex_range>& ranges)
+	{
+		std::vector<regex_range> result;
+		std::uint64_t next = 0;
+		for (const auto& range : ranges)
+		{
+			if (next < range.first)
+			{
+				result.push_back({static_cast<char32_t>(next), static_cast<char32_t>(range.first - 1)});
+			}
+			next = std::uint64_t{range.last} + 1;
+		}
+		if (next <= 0xFFFF'FFFF)
+		{
+			result.push_back({static_cast<char32_t>(next), char32_t{0xFFFF'FFFF}});
+		}
+		ranges = std::move(result);
+	}
+
+	/// @brief \d, \w, \s とその否定を範囲として追加する
+	constexpr void regex_add_shorthand(std::vector<regex_range>& ranges, char32_t kind)
+	{
+		std::vector<regex_range> set;
+		switch (kind)
+		{
+		case U'd': case U'D':
+			set = {{U'0', U'9'}};
+			break;
+		case U'w': case U'W':
+			set = {{U'0', U'9'}, {U'A', U'Z'}, {U'_', U'_'}, {U'a', U'z'}};
+			break;
+		default:
+			set = {
+				{0x09, 0x0D}, {0x20, 0x20}, {0xA0, 0xA0}, {0x1680, 0x1680}, {0x2000, 0x200A},
+				{0x2028, 0x2029}, {0x202F, 0x202F}, {0x205F, 0x205F}, {0x3000, 0x3000}, {0xFEFF, 0xFEFF}};
+			break;
+		}
+		if (kind == U'D' || kind == U'W' || kind == U'S')
+		{
+			regex_complement(set);
+		}
+		ranges.insert(ranges.end(), set.begin(), set.end());
+	}
+
+	/// @brief ECMAScript風の構文を解析し、Thompson構成のプログラムを出力する
+	/// @details 対応する構文: 選択、グループ (キャプチャ / (?:...))、量指定子 (* + ? {n,m} と最短一致)、
+	///          文字クラス、., ^, $, \b, \B, \d \w \s とその否定、\n \r \t \f \v \0 \xHH \uHHHH \u{H...}
+	template<class TChar>
+	class regex_parser final
+	{
+	public:
+		// --- コンストラクタ
+		PUPPY_NODISCARD_CTOR
+		constexpr explicit regex_parser(basic_string_view<TChar> pattern, regex_compiled& out) noexcept
+			: _pattern{pattern}, _out{out}
+		{}
+
+		// --- 操作メソッド
+		constexpr void parse()
+		{
+			const auto root = parse_alternation();
+			if (!failed() && _position < _pattern.size())
+			{
+				fail(regex_error::unmatched_parenthesis);
+			}
+			if (failed())
+			{
+				return;
+			}
+			_out.capture_count = _captures;
+
+			emit({regex_op::save, 0, 0});
+			emit(root);
+			emit({regex_op::save, 0, 1});
+			emit({regex_op::match});
+		}
+
+	private:
+		// --- 内部メソッド (字句)
+		[[nodiscard]]
+		constexpr bool failed() const noexcept
+		{
+			return _out.error != regex_error::none;
+		}
+
+		constexpr std::uint32_t fail(regex_error error) noexcept
+		{
+			if (!failed())
+			{
+				_out.error = error;
+				_out.error_position = _position;
+			}
+			return 0;
+		}
+
+		[[nodiscard]]
+		constexpr bool peek(char32_t c) const noexcept
+		{
+			return _position < _pattern.size() && regex_code(_pattern[_position]) == c;
+		}
+
+		constexpr bool consume(char32_t c) noexcept
+		{
+			if (peek(c))
+			{
+				++_position;
+				return true;
+			}
+			return false;
+		}
+
+		constexpr bool next(char32_t& c) noexcept
+		{
+			if (_position >= _pattern.size())
+			{
+				fail(regex_error::unexpected_end);
+				return false;
+			}
+			c = regex_code(_pattern[_position++]);
+			return true;
+		}
+
+		constexpr std::uint32_t add(const regex_node& node)
+		{
+			_nodes.push_back(node);
+			return static_cast<std::uint32_t>(_nodes.size() - 1);
+		}
+
+		[[nodiscard]]
+		static constexpr int hex_value(char32_t c) noexcept
+		{
+			if (c >= U'0' && c <= U'9') return static_cast<int>(c - U'0');
+			if (c >= U'a' && c <= U'f') return static_cast<int>(c - U'a' + 10);
+			if (c >= U'A' && c <= U'F') return static_cast<int>(c - U'A' + 10);
+			return -1;
+		}
+
+		constexpr bool parse_hex(size_t digits, char32_t& value) noexcept
+		{
+			value = 0;
+			for (size_t i = 0; i < digits; ++i)
+			{
+				char32_t c = 0;
+				if (!next(c) || hex_value(c) < 0)
+				{
+					fail(regex_error::invalid_escape);
+					return false;
+				}
+				value = value << 4 | static_cast<char32_t>(hex_value(c));
+			}
+			return true;
+		}
+
+		// --- 内部メソッド (構文)
+		constexpr std::uint32_t parse_alternation()
+		{
+			auto node = parse_concat();
+			while (!failed() && consume(U'|'))
+			{
+				const auto rhs = parse_concat();
+				node = add({regex_node_kind::alternate, 0, node, rhs});
+			}
+			return node;
+		}
+
+		constexpr std::uint32_t parse_concat()
+		{
+			std::uint32_t node = add({regex_node_kind::empty});
+			bool first = true;
+			while (!failed() && _position < _pattern.size() && !peek(U'|') && !peek(U')'))
+			{
+				const auto term = parse_repeat();
+				node = first ? term : add({regex_node_kind::concat, 0, node, term});
+				first = false;
+			}
+			return node;
+		}
+
+		/// @brief 量指定子を読み取る (構文として成立しない { は読み進めない)
+		constexpr bool parse_quantifier(std::uint32_t& min, std::uint32_t& max)
+		{
+			if (consume(U'*')) { min = 0; max = regex_unbounded; return true; }
+			if (consume(U'+')) { min = 1; max = regex_unbounded; return true; }
+			if (consume(U'?')) { min = 0; max = 1; return true; }
+			if (!peek(U'{'))
+			{
+				return false;
+			}
+
+			const size_t start = _position++;
+			const auto read_number = [this](std::uint32_t& value)
+			{
+				bool any = false;
+				value = 0;
+				while (_position < _pattern.size())
+				{
+					const char32_t c = regex_code(_pattern[_position]);
+					if (c < U'0' || c > U'9')
+					{
+						break;
+					}
+					value = std::min<std::uint32_t>(value * 10 + (c - U'0'), regex_repeat_limit + 1);
+					any = true;
+					++_position;
+				}
+				return any;
+			};
+
+			if (!read_number(min))
+			{
+				_position = start;
+				return false;
+			}
+			max = min;
+			if (consume(U','))
+			{
+				if (!read_number(max))
+				{
+					max = regex_unbounded;
+				}
+			}
+			if (!consume(U'}'))
+			{
+				_position = start;
+				return false;
+			}
+			if (min > regex_repeat_limit || (max != regex_unbounded && (max > regex_repeat_limit || max < min)))
+			{
+				fail(regex_error::invalid_repeat);
+			}
+			return true;
+		}
+
+		constexpr std::uint32_t parse_repeat()
+		{
+			// グループで囲んだアサーションは繰り返せる
+			const bool group = peek(U'(');
+			const auto atom = parse_atom();
+			if (failed())
+			{
+				return 0;
+			}
+
+			std::uint32_t min = 0;
+			std::uint32_t max = 0;
+			if (!parse_quantifier(min, max) || failed())
+			{
+				return atom;
+			}
+			const auto kind = _nodes[atom].kind;
+			if (!group && (kind == regex_node_kind::assert_begin || kind == regex_node_kind::assert_end
+			 || kind == regex_node_kind::word_boundary || kind == regex_node_kind::not_word_boundary))
+			{
+				return fail(regex_error::nothing_to_repeat);
+			}
+			const bool lazy = consume(U'?');
+
+			// a** のような連続した量指定子は誤り
+			std::uint32_t dummy_min = 0;
+			std::uint32_t dummy_max = 0;
+			const size_t position = _position;
+			if (parse_quantifier(dummy_min, dummy_max))
+			{
+				_position = position;
+				return fail(regex_error::nothing_to_repeat);
+			}
+			return add({regex_node_kind::repeat, 0, atom, 0, min, max, lazy});
+		}
+
+		constexpr std::uint32_t parse_atom()
+		{
+			const size_t start = _position;
+			char32_t c = 0;
+			if (!next(c))
+			{
+				return 0;
+			}
+
+			switch (c)
+			{
+			case U'(':
+			{
+				bool capture = true;
+				if (consume(U'?'))
+				{
+					if (!consume(U':'))
+					{
+						return fail(regex_error::unsupported);
+					}
+					capture = false;
+				}
+				const std::uint32_t index = capture ? static_cast<std::uint32_t>(_captures++) : 0;
+				const auto inner = parse_alternation();
+				if (failed())
+				{
+					return 0;
+				}
+				if (!consume(U')'))
+				{
+					return fail(regex_error::unmatched_parenthesis);
+				}
+				return capture ? add({regex_node_kind::capture, index, inner}) : inner;
+			}
+			case U'[':
+				return parse_class();
+			case U'.':
+			{
+				std::vector<regex_range> ranges{{U'\n', U'\n'}, {U'\r', U'\r'}, {0x2028, 0x2029}};
+				regex_complement(ranges);
+				return add({regex_node_kind::char_class, finish_class(ranges)});
+			}
+			case U'^':
+				return add({regex_node_kind::assert_begin});
+			case U'$':
+				return add({regex_node_kind::assert_end});
+			case U'\\':
+				return parse_escape();
+			case U'*': case U'+': case U'?':
+				_position = start;
+				return fail(regex_error::nothing_to_repeat);
+			case U'{':
+			{
+				_position = start;
+				std::uint32_t min = 0;
+				std::uint32_t max = 0;
+				if (parse_quantifier(min, max))
+				{
+					_position = start;
+					return fail(regex_error::nothing_to_repeat);
+				}
+				++_position;
+				return add({regex_node_kind::literal, c});
+			}
+			default:
+				return add({regex_node_kind::literal, c});
+			}
+		}
+
+		/// @brief 文字を表すエスケープを読み取る
+		/// @return 文字を表すエスケープであればtrue
+		constexpr bool parse_char_escape(char32_t c, char32_t& value)
+		{
+			switch (c)
+			{
+			case U'n': value = U'\n'; return true;
+			case U'r': value = U'\r'; return true;
+			case U't': value = U'\t'; return true;
+			case U'f': value = U'\f'; return true;
+			case U'v': value = U'\v'; return true;
+			case U'0': value = 0; return true;
+			case U'x': return parse_hex(2, value);
+			case U'u':
+				if (consume(U'{'))
+				{
+					value = 0;
+					size_t digits = 0;
+					while (!consume(U'}'))
+					{
+						char32_t digit = 0;
+						if (!next(digit) || hex_value(digit) < 0 || ++digits > 8)
+						{
+							fail(regex_error::invalid_escape);
+							return false;
+						}
+						value = value << 4 | static_cast<char32_t>(hex_value(digit));
+					}
+					if (digits == 0)
+					{
+						fail(regex_error::invalid_escape);
+						return false;
+					}
+					return true;
+				}
+				return parse_hex(4, value);
+			default:
+				// 英数字以外はその文字自身を表す
+				if (regex_is_word(c))
+				{
+					fail(regex_error::invalid_escape);
+					return false;
+				}
+				value = c;
+				return true;
+			}
+		}
+
+		constexpr std::uint32_t parse_escape()
+		{
+			char32_t c = 0;
+			if (!next(c))
+			{
+				return 0;
+			}
+
+			switch (c)
+			{
+			case U'd': case U'D': case U'w': case U'W': case U's': case U'S':
+			{
+				std::vector<regex_range> ranges;
+				regex_add_shorthand(ranges, c);
+				regex_normalize(ranges);
+				return add({regex_node_kind::char_class, finish_class(ranges)});
+			}
+			case U'b':
+				return add({regex_node_kind::word_boundary});
+			case U'B':
+				return add({regex_node_kind::not_word_boundary});
+			default:
+				if (c >= U'1' && c <= U'9')
+				{
+					// 後方参照は有限オートマトンで表現できないため対応しない
+					return fail(regex_error::unsupported);
+				}
+				char32_t value = 0;
+				if (!parse_char_escape(c, value))
+				{
+					return 0;
+				}
+				return add({regex_node_kind::literal, value});
+			}
+		}
+
+		/// @brief 文字クラスの要素を1つ読み取る
+		/// @return 単一の文字であればtrue、\d などの集合であればfalse
+		constexpr bool parse_class_atom(std::vector<regex_range>& ranges, char32_t& value)
+		{
+			if (!next(value))
+			{
+				return false;
+			}
+			if (value != U'\\')
+			{
+				return true;
+			}
+
+			char32_t c = 0;
+			if (!next(c))
+			{
+				return false;
+			}
+			switch (c)
+			{
+			case U'd': case U'D': case U'w': case U'W': case U's': case U'S':
+				regex_add_shorthand(ranges, c);
+				return false;
+			case U'b':
+				value = U'\b';
+				return true;
+			case U'-':
+				value = c;
+				return true;
+			default:
+				return parse_char_escape(c, value);
+			}
+		}
+
+		constexpr std::uint32_t parse_class()
+		{
+			const bool negated = consume(U'^');
+			std::vector<regex_range> ranges;
+			while (!consume(U']'))
+			{
+				char32_t first = 0;
+				const bool single = parse_class_atom(ranges, first);
+				if (failed())
+				{
+					return 0;
+				}
+				if (_position + 1 < _pattern.size() && peek(U'-') && regex_code(_pattern[_position + 1]) != U']')
+				{
+					++_position;
+					char32_t last = 0;
+					const bool range = parse_class_atom(ranges, last);
+					if (failed())
+					{
+						return 0;
+					}
+					if (!single || !range || first > last)
+					{
+						return fail(regex_error::invalid_class);
+					}
+					ranges.push_back({first, last});
+				}
+				else if (single)
+				{
+					ranges.push_back({first, first});
+				}
+			}
+
+			regex_normalize(ranges);
+			if (negated)
+			{
+				regex_complement(ranges);
+			}
+			return add({regex_node_kind::char_class, finish_class(ranges)});
+		}
+
+		constexpr std::uint32_t finish_class(const std::vector<regex_range>& ranges)
+		{
+			regex_class cls{static_cast<std::uint32_t>(_out.ranges.size()), static_cast<std::uint32_t>(ranges.size())};
+			for (const auto& range : ranges)
+			{
+				for (char32_t c = range.first; c <= range.last && c < 128; ++c)
+				{
+					cls.ascii[c >> 6] |= std::uint64_t{1} << (c & 63);
+				}
+				_out.ranges.push_back(range);
+			}
+			_out.classes.push_back(cls);
+			return static_cast<std::uint32_t>(_out.classes.size() - 1);
+		}
+
+		// --- 内部メソッド (コード生成)
+		constexpr std::uint32_t emit(const regex_instruction& instruction)
+		{
+			if (_out.program.size() >= regex_program_limit)
+			{
+				fail(regex_error::too_complex);
+			}
+			_out.program.push_back(instruction);
+			return static_cast<std::uint32_t>(_out.program.size() - 1);
+		}
+
+		[[nodiscard]]
+		constexpr std::uint32_t here() const noexcept
+		{
+			return static_cast<std::uint32_t>(_out.program.size());
+		}
+
+		constexpr void emit(std::uint32_t index)
+		{
+			if (failed())
+			{
+				return;
+			}
+
+			const regex_node node = _nodes[index];
+			switch (node.kind)
+			{
+			case regex_node_kind::empty:
+				break;
+			case regex_node_kind::literal:
+				emit({regex_op::character, node.value});
+				break;
+			case regex_node_kind::char_class:
+				emit({regex_op::char_class, 0, node.value});
+				break;
+			case regex_node_kind::concat:
+				emit(node.left);
+				emit(node.right);
+				break;
+			case regex_node_kind::alternate:
+			{
+				const auto split = emit({regex_op::split});
+				_out.program[split].x = here();
+				emit(node.left);
+				const auto jump = emit({regex_op::jump});
+				_out.program[split].y = here();
+				emit(node.right);
+				_out.program[jump].x = here();
+				break;
+			}
+			case regex_node_kind::capture:
+				emit({regex_op::save, 0, node.value * 2});
+				emit(node.left);
+				emit({regex_op::save, 0, node.value * 2 + 1});
+				break;
+			case regex_node_kind::repeat:
+				emit_repeat(node);
+				break;
+			case regex_node_kind::assert_begin:
+				emit({regex_op::assert_begin});
+				break;
+			case regex_node_kind::assert_end:
+				emit({regex_op::assert_end});
+				break;
+			case regex_node_kind::word_boundary:
+				emit({regex_op::word_boundary});
+				break;
+			case regex_node_kind::not_word_boundary:
+				emit({regex_op::not_word_boundary});
+				break;
+			}
+		}
+
+		constexpr void emit_repeat(const regex_node& node)
+		{
+			for (std::uint32_t i = 0; i < node.min && !failed(); ++i)
+			{
+				emit(node.left);
+			}
+
+			const auto link = [&](std::uint32_t split, std::uint32_t body, std::uint32_t exit)
+			{
+				_out.program[split].x = node.lazy ? exit : body;
+				_out.program[split].y = node.lazy ? body : exit;
+			};
+
+			if (node.max == regex_unbounded)
+			{
+				const auto loop = emit({regex_op::split});
+				emit(node.left);
+				emit({regex_op::jump, 0, loop});
+				link(loop, loop + 1, here());
+				return;
+			}
+
+			// x{0,2} は (x(x)?)? として展開する
+			std::vector<std::uint32_t> splits;
+			for (std::uint32_t i = node.min; i < node.max && !failed(); ++i)
+			{
+				splits.push_back(emit({regex_op::split}));
+				emit(node.left);
+			}
+			if (failed())
+			{
+				return;
+			}
+			for (const auto split : splits)
+			{
+				link(split, split + 1, here());
+			}
+		}
+
+		// --- メンバ変数定義
+		basic_string_view<TChar> _pattern;
+		regex_compiled& _out;
+		std::vector<regex_node> _nodes;
+		size_t _position = 0;
+		size_t _captures = 1;
+	};
+
+	// --- 部分集合構成法によるDFAの構築
+
+	using regex_state_set = std::array<std::uint64_t, regex_dfa_program_limit / 64>;
+
+	/// @brief DFAの構築に使う補助
+	class regex_dfa_builder final
+	{
+	public:
+		PUPPY_NODISCARD_CTOR
+		constexpr explicit regex_dfa_builder(const regex_compiled& compiled) noexcept
+			: _compiled{compiled}
+		{}
+
+		/// @brief DFAを構築する
+		/// @param search trueであれば全ての位置から照合を開始するDFAを構築する
+		/// @return 状態数が上限を超えた場合はfalse
+		constexpr bool build(regex_compiled::dfa& dfa, bool search) const
+		{
+			const size_t class_count = _compiled.dfa_boundaries.size();
+			const regex_state_set restart = closure(single(0), false);
+
+			std::vector<regex_state_set> states{regex_state_set{}, closure(single(0), true)};
+			for (size_t state = 0; state < states.size(); ++state)
+			{
+				const regex_state_set set = states[state];
+				for (size_t cls = 0; cls < class_count; ++cls)
+				{
+					regex_state_set core{};
+					const char32_t c = _compiled.dfa_boundaries[cls];
+					for_each(set, [&](size_t pc)
+					{
+						const auto& instruction = _compiled.program[pc];
+						if (consumes(instruction, c))
+						{
+							insert(core, pc + 1);
+						}
+					});
+
+					regex_state_set target = closure(core, false);
+					if (search)
+					{
+						for (size_t i = 0; i < target.size(); ++i)
+						{
+							target[i] |= restart[i];
+						}
+					}
+
+					const auto found = std::find(states.begin(), states.end(), target);
+					const auto index = static_cast<size_t>(found - states.begin());
+					if (found == states.end())
+					{
+						if (states.size() >= regex_dfa_state_limit)
+						{
+							return false;
+						}
+						states.push_back(target);
+					}
+					dfa.transitions.push_back(static_cast<std::uint8_t>(index));
+				}
+
+				std::uint8_t flags = 0;
+				if (contains_match(set))
+				{
+					flags |= regex_state_accepting;
+				}
+				if (contains_match(closure(set, false, true)))
+				{
+					flags |= regex_state_accepting_at_end;
+				}
+				dfa.flags.push_back(flags);
+			}
+			return true;
+		}
+
+	private:
+		[[nodiscard]]
+		static constexpr regex_state_set single(size_t pc) noexcept
+		{
+			regex_state_set set{};
+			insert(set, pc);
+			return set;
+		}
+
+		static constexpr void insert(regex_state_set& set, size_t pc) noexcept
+		{
+			set[pc >> 6] |= std::uint64_t{1} << (pc & 63);
+		}
+
+		[[nodiscard]]
+		static constexpr bool contains(const regex_state_set& set, size_t pc) noexcept
+		{
+			return (set[pc >> 6] >> (pc & 63)) & 1;
+		}
+
+		template<class TFunc>
+		static constexpr void for_each(const regex_state_set& set, TFunc&& func)
+		{
+			for (size_t i = 0; i < set.size(); ++i)
+			{
+				for (std::uint64_t bits = set[i]; bits != 0; bits &= bits - 1)
+				{
+					func(i * 64 + static_cast<size_t>(std::countr_zero(bits)));
+				}
+			}
+		}
+
+		[[nodiscard]]
+		constexpr bool consumes(const regex_instruction& instruction, char32_t c) const noexcept
+		{
+			if (instruction.op == regex_op::character)
+			{
+				return instruction.value == c;
+			}
+			if (instruction.op == regex_op::char_class)
+			{
+				const auto& cls = _compiled.classes[instruction.x];
+				for (size_t i = cls.first; i < cls.first + cls.count; ++i)
+				{
+					if (_compiled.ranges[i].first <= c && c <= _compiled.ranges[i].last)
+					{
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		[[nodiscard]]
+		constexpr bool contains_match(const regex_state_set& set) const noexcept
+		{
+			return contains(set, _compiled.program.size() - 1);
+		}
+
+		/// @brief 文字を消費しない遷移で到達できる命令の集合を返す
+		/// @details アサーション自身も集合に含め、末尾での判定時に続きを辿れるようにする
+		[[nodiscard]]
+		constexpr regex_state_set closure(const regex_state_set& core, bool at_begin, bool at_end = false) const
+		{
+			regex_state_set result{};
+			std::vector<size_t> stack;
+			for_each(core, [&](size_t pc) { stack.push_back(pc); });
+
+			while (!stack.empty())
+			{
+				const size_t pc = stack.back();
+				stack.pop_back();
+				if (contains(result, pc))
+				{
+					continue;
+				}
+				insert(result, pc);
+
+				const auto& instruction = _compiled.program[pc];
+				switch (instruction.op)
+				{
+				case regex_op::jump:
+					stack.push_back(instruction.x);
+					break;
+				case regex_op::split:
+					stack.push_back(instruction.y);
+					stack.push_back(instruction.x);
+					break;
+				case regex_op::save:
+					stack.push_back(pc + 1);
+					break;
+				case regex_op::assert_begin:
+					if (at_begin)
+					{
+						stack.push_back(pc + 1);
+					}
+					break;
+				case regex_op::assert_end:
+					if (at_end)
+					{
+						stack.push_back(pc + 1);
+					}
+					break;
+				default:
+					break;
+				}
+			}
+			return result;
+		}
+
+		// --- メンバ変数定義
+		const regex_compiled& _compiled;
+	};
+
+	/// @brief DFAを構築できる場合は構築する
+	constexpr void regex_build_dfa(regex_compiled& compiled)
+	{
+		if (compiled.program.size() > regex_dfa_program_limit)
+		{
+			return;
+		}
+
+		// 単語境界は前後の文字に依存するため、先頭アサーションは先頭以外にある場合にDFAで表現できない
+		bool leading = true;
+		for (const auto& instruction : compiled.program)
+		{
+			if (instruction.op == regex_op::word_boundary || instruction.op == regex_op::not_word_boundary
+			 || (instruction.op == regex_op::assert_begin && !leading))
+			{
+				return;
+			}
+			leading = leading && (instruction.op == regex_op::save || instruction.op == regex_op::assert_begin);
+		}
+
+		// 照合に影響する文字の境界で文字全体を同値類に分割する
+		std::vector<std::uint64_t> points{0};
+		const auto add_range = [&](std::uint64_t first, std::uint64_t last)
+		{
+			points.push_back(first);
+			if (last < 0xFFFF'FFFF)
+			{
+				points.push_back(last + 1);
+			}
+		};
+		for (const auto& instruction : compiled.program)
+		{
+			if (instruction.op == regex_op::character)
+			{
+				add_range(instruction.value, instruction.value);
+			}
+		}
+		for (const auto& range : compiled.ranges)
+		{
+			add_range(range.first, range.last);
+		}
+		std::sort(points.begin(), points.end());
+		points.erase(std::unique(points.begin(), points.end()), points.end());
+		if (points.size() > regex_dfa_class_limit)
+		{
+			return;
+		}
+		for (const auto point : points)
+		{
+			compiled.dfa_boundaries.push_back(static_cast<char32_t>(point));
+		}
+
+		const regex_dfa_builder builder{compiled};
+		if (!builder.build(compiled.match_dfa, false) || !builder.build(compiled.search_dfa, true))
+		{
+			compiled.dfa_boundaries.clear();
+			compiled.match_dfa = {};
+			compiled.search_dfa = {};
+		}
+	}
+
+	/// @brief パターンを解析して中間表現を構築する
+	template<class TChar>
+	[[nodiscard]]
+	constexpr regex_compiled regex_compile(basic_string_view<TChar> pattern)
+	{
+		regex_compiled compiled;
+		regex_parser<TChar>{pattern, compiled}.parse();
+		if (compiled.error != regex_error::none)
+		{
+			compiled.program.clear();
+			compiled.ranges.clear();
+			compiled.classes.clear();
+			return compiled;
+		}
+
+		// 全てのマッチが必ず始まるリテラル接頭辞を求める
+		size_t pc = 0;
+		while (compiled.program[pc].op == regex_op::save)
+		{
+			++pc;
+		}
+		compiled.anchored = compiled.program[pc].op == regex_op::assert_begin;
+		for (; pc < compiled.program.size() && compiled.prefix.size() < regex_prefix_limit; ++pc)
+		{
+			const auto& instruction = compiled.program[pc];
+			if (instruction.op == regex_op::character)
+			{
+				compiled.prefix.push_back(instruction.value);
+			}
+			else if (instruction.op != regex_op::save)
+			{
+				break;
+			}
+		}
+		if (compiled.anchored)
+		{
+			compiled.prefix.clear();
+		}
+
+		regex_build_dfa(compiled);
+		return compiled;
+	}
+
+	/// @brief 固定長の配列に格納するための各要素数
+	struct regex_sizes final
+	{
+		regex_error error = regex_error::none;
+		size_t error_position = 0;
+		size_t capture_count = 0;
+		bool anchored = false;
+		size_t program = 0;
+		size_t ranges = 0;
+		size_t classes = 0;
+		size_t prefix = 0;
+		size_t dfa_classes = 0;
+		size_t match_dfa_states = 0;
+		size_t search_dfa_states = 0;
+	};
+
+	/// @brief 実行時に使う固定長のプログラム
+	template<regex_sizes Sizes>
+	struct regex_data final
+	{
+		std::array<regex_instruction, Sizes.program> program{};
+		std::array<regex_range, Sizes.ranges> ranges{};
+		std::array<regex_class, Sizes.classes> classes{};
+		std::array<char32_t, Sizes.prefix> prefix{};
+		std::array<char32_t, Sizes.dfa_classes> dfa_boundaries{};
+		std::array<std::uint8_t, 128> dfa_ascii{};
+		std::array<std::uint8_t, Sizes.match_dfa_states * Sizes.dfa_classes> match_transitions{};
+		std::array<std::uint8_t, Sizes.match_dfa_states> match_flags{};
+		std::array<std::uint8_t, Sizes.search_dfa_states * Sizes.dfa_classes> search_transitions{};
+		std::array<std::uint8_t, Sizes.search_dfa_states> search_flags{};
+	};
+
+	/// @brief 範囲 [first, last) から文字を探す
+	/// @return 見つかった位置、見つからなければlast
+	template<class TChar>
+	[[nodiscard]]
+	inline size_t regex_find_unit(const TChar* data, size_t first, size_t last, TChar unit) noexcept
+	{
+#if PUPPY_INTRINSIC_SSE2
+		if constexpr (sizeof(TChar) == 1 || sizeof(TChar) == 2 || sizeof(TChar) == 4)
+		{
+			constexpr size_t lanes = 16 / sizeof(TChar);
+			__m128i needle;
+			if constexpr (sizeof(TChar) == 1)
+			{
+				needle = _mm_set1_epi8(static_cast<char>(unit));
+			}
+			else if constexpr (sizeof(TChar) == 2)
+			{
+				needle = _mm_set1_epi16(static_cast<short>(unit));
+			}
+			else
+			{
+				needle = _mm_set1_epi32(static_cast<int>(unit));
+			}
+
+			for (; first + lanes <= last; first += lanes)
+			{
+				const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + first));
+				__m128i equal;
+				if constexpr (sizeof(TChar) == 1)
+				{
+					equal = _mm_cmpeq_epi8(block, needle);
+				}
+				else if constexpr (sizeof(TChar) == 2)
+				{
+					equal = _mm_cmpeq_epi16(block, needle);
+				}
+				else
+				{
+					equal = _mm_cmpeq_epi32(block, needle);
+				}
+
+				const auto mask = static_cast<unsigned>(_mm_movemask_epi8(equal));
+				if (mask != 0)
+				{
+					return first + static_cast<size_t>(std::countr_zero(mask)) / sizeof(TChar);
+				}
+			}
+		}
+#endif
+		if (first >= last)
+		{
+			return last;
+		}
+		const TChar* found = std::char_traits<TChar>::find(data + first, last - first, unit);
+		return found != nullptr ? static_cast<size_t>(found - data) : last;
+	}
+
+	/// @brief コンパイル済みのパターンを照合するエンジン
+	/// @details DFAを構築できたパターンの真偽判定はDFAで、キャプチャが必要な照合は
+	///          Pike VMでマッチの位置に依らず線形時間で行う
+	template<fixed_string Pattern>
+	struct regex_engine final
+	{
+		static constexpr regex_sizes sizes = []
+		{
+			const auto compiled = regex_compile(Pattern.view());
+			return regex_sizes{
+				compiled.error, compiled.error_position, compiled.capture_count, compiled.anchored,
+				compiled.program.size(), compiled.ranges.size(), compiled.classes.size(), compiled.prefix.size(),
+				compiled.dfa_boundaries.size(), compiled.match_dfa.flags.size(), compiled.search_dfa.flags.size()};
+		}();
+
+		static constexpr regex_data<sizes> data = []
+		{
+			const auto compiled = regex_compile(Pattern.view());
+			regex_data<sizes> result;
+			std::copy_n(compiled.program.begin(), sizes.program, result.program.begin());
+			std::copy_n(compiled.ranges.begin(), sizes.ranges, result.ranges.begin());
+			std::copy_n(compiled.classes.begin(), sizes.classes, result.classes.begin());
+			std::copy_n(compiled.prefix.begin(), sizes.prefix, result.prefix.begin());
+			std::copy_n(compiled.dfa_boundaries.begin(), sizes.dfa_classes, result.dfa_boundaries.begin());
+			std::copy_n(compiled.match_dfa.transitions.begin(), result.match_transitions.size(), result.match_transitions.begin());
+			std::copy_n(compiled.match_dfa.flags.begin(), sizes.match_dfa_states, result.match_flags.begin());
+			std::copy_n(compiled.search_dfa.transitions.begin(), result.search_transitions.size(), result.search_transitions.begin());
+			std::copy_n(compiled.search_dfa.flags.begin(), sizes.search_dfa_states, result.search_flags.begin());
+			if constexpr (sizes.dfa_classes != 0)
+			{
+				for (char32_t c = 0; c < 128; ++c)
+				{
+					const auto found = std::upper_bound(result.dfa_boundaries.begin(), result.dfa_boundaries.end(), c);
+					result.dfa_ascii[c] = static_cast<std::uint8_t>(found - result.dfa_boundaries.begin() - 1);
+				}
+			}
+			return result;
+		}();
+
+		static constexpr size_t slot_count = sizes.capture_count * 2;
+		static constexpr bool has_dfa = sizes.dfa_classes != 0;
+		static constexpr size_t npos = static_cast<size_t>(-1);
+
+		using slots_type = std::array<size_t, slot_count>;
+
+		// --- 文字の判定
+
+		[[nodiscard]]
+		static constexpr bool class_contains(std::uint32_t index, char32_t c) noexcept
+		{
+			const auto& cls = data.classes[index];
+			if (c < 128)
+			{
+				return (cls.ascii[c >> 6] >> (c & 63)) & 1;
+			}
+			const auto first = data.ranges.begin() + cls.first;
+			const auto last = first + cls.count;
+			const auto found = std::upper_bound(first, last, c, [](char32_t value, const regex_range& range)
+			{
+				return value < range.first;
+			});
+			return found != first && c <= (found - 1)->last;
+		}
+
+		[[nodiscard]]
+		PUPPY_FORCE_INLINE
+		static constexpr bool consumes(const regex_instruction& instruction, char32_t c) noexcept
+		{
+			if (instruction.op == regex_op::character)
+			{
+				return instruction.value == c;
+			}
+			return instruction.op == regex_op::char_class && class_contains(instruction.x, c);
+		}
+
+		template<class TChar, class TTraits>
+		[[nodiscard]]
+		static constexpr bool at_word_boundary(basic_string_view<TChar, TTraits> text, size_t pos) noexcept
+		{
+			const bool before = pos > 0 && regex_is_word(regex_code(text[pos - 1]));
+			const bool after = pos < text.size() && regex_is_word(regex_code(text[pos]));
+			return before != after;
+		}
+
+		// --- リテラル接頭辞による候補位置の絞り込み
+
+		/// @brief pos以降で接頭辞が現れる位置を返す
+		/// @return 見つからなければ文字列の長さ
+		template<class TChar, class TTraits>
+		[[nodiscard]]
+		static constexpr size_t find_prefix(basic_string_view<TChar, TTraits> text, size_t pos) noexcept
+		{
+			const size_t size = text.size();
+			const auto unit = static_cast<TChar>(data.prefix[0]);
+			if (size < sizes.prefix || regex_code(unit) != data.prefix[0])
+			{
+				return size;
+			}
+
+			const size_t last = size - sizes.prefix + 1;
+			while (pos < last)
+			{
+				if (std::is_constant_evaluated())
+				{
+					while (pos < last && regex_code(text[pos]) != data.prefix[0])
+					{
+						++pos;
+					}
+				}
+				else
+				{
+					pos = regex_find_unit(text.data(), pos, last, unit);
+				}
+				if (pos >= last)
+				{
+					break;
+				}
+
+				size_t i = 1;
+				while (i < sizes.prefix && regex_code(text[pos + i]) == data.prefix[i])
+				{
+					++i;
+				}
+				if (i == sizes.prefix)
+				{
+					return pos;
+				}
+				++pos;
+			}
+			return size;
+		}
+
+		// --- DFA
+
+		[[nodiscard]]
+		PUPPY_FORCE_INLINE
+		static constexpr size_t dfa_class(char32_t c) noexcept
+		{
+			if (c < 128)
+			{
+				return data.dfa_ascii[c];
+			}
+			const auto found = std::upper_bound(data.dfa_boundaries.begin(), data.dfa_boundaries.end(), c);
+			return static_cast<size_t>(found - data.dfa_boundaries.begin() - 1);
+		}
+
+		template<class TChar, class TTraits>
+		[[nodiscard]]
+		static constexpr bool dfa_matches(basic_string_view<TChar, TTraits> text) noexcept
+		{
+			size_t state = 1;
+			for (const TChar c : text)
+			{
+				state = data.match_transitions[state * sizes.dfa_classes + dfa_class(regex_code(c))];
+				if (state == 0)
+				{
+					return false;
+				}
+			}
+			return data.match_flags[state] & regex_state_accepting_at_end;
+		}
+
+		template<class TChar, class TTraits>
+		[[nodiscard]]
+		static constexpr bool dfa_contains(basic_string_view<TChar, TTraits> text) noexcept
+		{
+			size_t pos = 0;
+			if constexpr (sizes.prefix != 0)
+			{
+				// 最初の候補位置より前にはマッチが存在しない
+				pos = find_prefix(text, 0);
+				if (pos == text.size())
+				{
+					return false;
+				}
+			}
+
+			size_t state = 1;
+			for (; pos < text.size(); ++pos)
+			{
+				if (data.search_flags[state] & regex_state_accepting)
+				{
+					return true;
+				}
+				state = data.search_transitions[state * sizes.dfa_classes + dfa_class(regex_code(text[pos]))];
+				if (state == 0)
+				{
+					return false;
+				}
+			}
+			return data.search_flags[state] & (regex_state_accepting | regex_state_accepting_at_end);
+		}
+
+		// --- Pike VM
+
+		/// @brief εクロージャを辿る作業
+		/// @details slotがno_slotであればpcを訪れ、そうでなければキャプチャスロットslotをvalueに戻す
+		struct thread_task final
+		{
+			static constexpr std::uint32_t no_slot = UINT32_MAX;
+
+			std::uint32_t pc = 0;
+			std::uint32_t slot = no_slot;
+			size_t value = 0;
+		};
+
+		// 各命令は1回のεクロージャで高々1度だけ展開され、展開ごとに積む作業は2つ以下
+		static constexpr size_t task_capacity = sizes.program * 2 + 1;
+
+		// 2つのスレッドリストと作業スタックの合計の大きさ
+		static constexpr size_t thread_bytes =
+			sizes.program * 2 * (sizeof(std::uint32_t) + sizeof(slots_type) + sizeof(size_t))
+			+ task_capacity * sizeof(thread_task);
+		static constexpr bool heap_threads = thread_bytes > regex_stack_limit;
+
+		template<class T, size_t N>
+		using thread_buffer = std::conditional_t<heap_threads, std::vector<T>, std::array<T, N>>;
+
+		/// @brief 2つのスレッドリストと作業スタックの領域
+		/// @details 大きなパターンではワーカースレッドのスタックを溢れさせないよう、呼び出しごとに一度だけヒープに確保する
+		struct thread_storage final
+		{
+			thread_buffer<std::uint32_t, sizes.program * 2> pcs{};
+			thread_buffer<slots_type, sizes.program * 2> slots{};
+			thread_buffer<size_t, sizes.program * 2> marks{};
+			thread_buffer<thread_task, task_capacity> tasks{};
+
+			constexpr thread_storage()
+			{
+				if constexpr (heap_threads)
+				{
+					pcs.resize(sizes.program * 2);
+					slots.resize(sizes.program * 2);
+					marks.resize(sizes.program * 2);
+					tasks.resize(task_capacity);
+				}
+			}
+		};
+
+		struct thread_list final
+		{
+			std::uint32_t* pcs = nullptr;
+			slots_type* slots = nullptr;
+			size_t* marks = nullptr;
+			/// @brief 2つのリストで共有する作業スタック
+			thread_task* tasks = nullptr;
+			size_t size = 0;
+			size_t generation = 0;
+
+			constexpr thread_list(thread_storage& storage, size_t offset) noexcept
+				: pcs{storage.pcs.data() + offset}
+				, slots{storage.slots.data() + offset}
+				, marks{storage.marks.data() + offset}
+				, tasks{storage.tasks.data()}
+			{}
+
+			constexpr void clear() noexcept
+			{
+				size = 0;
+				++generation;
+			}
+		};
+
+		/// @brief pcからεクロージャを辿り、文字を消費する命令をスレッドとして追加する
+		/// @details 再帰するとスタックの深さがプログラムの大きさに比例するため、作業スタックで辿る。
+		///          分岐は優先する側を後に積み、saveは戻す作業を先に積むことで再帰と同じ順序になる
+		template<class TChar, class TTraits>
+		static constexpr void add_thread(
+			thread_list& list,
+			std::uint32_t pc,
+			slots_type& slots,
+			basic_string_view<TChar, TTraits> text,
+			size_t pos) noexcept
+		{
+			thread_task* tasks = list.tasks;
+			size_t count = 0;
+			tasks[count++] = {pc};
+			while (count != 0)
+			{
+				const thread_task task = tasks[--count];
+				if (task.slot != thread_task::no_slot)
+				{
+					slots[task.slot] = task.value;
+					continue;
+				}
+
+				pc = task.pc;
+				if (list.marks[pc] == list.generation)
+				{
+					continue;
+				}
+				list.marks[pc] = list.generation;
+
+				const auto& instruction = data.program[pc];
+				switch (instruction.op)
+				{
+				case regex_op::jump:
+					tasks[count++] = {instruction.x};
+					break;
+				case regex_op::split:
+					tasks[count++] = {instruction.y};
+					tasks[count++] = {instruction.x};
+					break;
+				case regex_op::save:
+					tasks[count++] = {0, instruction.x, slots[instruction.x]};
+					slots[instruction.x] = pos;
+					tasks[count++] = {pc + 1};
+					break;
+				case regex_op::assert_begin:
+					if (pos == 0)
+					{
+						tasks[count++] = {pc + 1};
+					}
+					break;
+				case regex_op::assert_end:
+					if (pos == text.size())
+					{
+						tasks[count++] = {pc + 1};
+					}
+					break;
+				case regex_op::word_boundary:
+				case regex_op::not_word_boundary:
+					if (at_word_boundary(text, pos) == (instruction.op == regex_op::word_boundary))
+					{
+						tasks[count++] = {pc + 1};
+					}
+					break;
+				default:
+					list.pcs[list.size] = pc;
+					list.slots[list.size] = slots;
+					++list.size;
+					break;
+				}
+			}
+		}
+
+		/// @brief 優先順位付きのスレッドを並行に進めて、最左かつ優先度の最も高いマッチを求める
+		/// @param full trueであれば文字列全体との一致のみを受理する
+		template<class TChar, class TTraits>
+		static constexpr bool execute(basic_string_view<TChar, TTraits> text, size_t start, bool full, slots_type& result) noexcept
+		{
+			const size_t size = text.size();
+			const bool anchored = full || sizes.anchored;
+			thread_storage storage;
+			thread_list lists[2] = {{storage, 0}, {storage, sizes.program}};
+			thread_list* current = &lists[0];
+			thread_list* next = &lists[1];
+			current->clear();
+
+			bool matched = false;
+			for (size_t pos = start;; ++pos)
+			{
+				// 低優先度のスレッドとして新しい開始位置を追加する
+				bool seed = !matched && (!anchored || pos == start) && (!sizes.anchored || pos == 0);
+				if constexpr (sizes.prefix != 0)
+				{
+					seed = seed && pos < size && regex_code(text[pos]) == data.prefix[0];
+				}
+				if (seed)
+				{
+					slots_type slots;
+					slots.fill(npos);
+					add_thread(*current, 0, slots, text, pos);
+				}
+
+				if (current->size == 0)
+				{
+					if (matched || anchored || pos >= size)
+					{
+						break;
+					}
+					current->clear();
+					if constexpr (sizes.prefix != 0)
+					{
+						const size_t candidate = find_prefix(text, pos + 1);
+						if (candidate >= size)
+						{
+							break;
+						}
+						pos = candidate - 1;
+					}
+					continue;
+				}
+
+				next->clear();
+				const char32_t c = pos < size ? regex_code(text[pos]) : 0;
+				for (size_t i = 0; i < current->size; ++i)
+				{
+					const auto pc = current->pcs[i];
+					const auto& instruction = data.program[pc];
+					if (instruction.op == regex_op::match)
+					{
+						if (full && pos != size)
+						{
+							continue;
+						}
+						// 以降のスレッドは優先度が低いため打ち切る
+						result = current->slots[i];
+						matched = true;
+						break;
+					}
+					if (pos < size && consumes(instruction, c))
+					{
+						add_thread(*next, pc + 1, current->slots[i], text, pos + 1);
+					}
+				}
+				std::swap(current, next);
+
+				if (pos >= size)
+				{
+					break;
+				}
+			}
+			return matched;
+		}
+	};
+}
+
+namespace puppy
+{
+	/// @brief 正規表現の照合結果
+	/// @tparam TChar 文字列の文字型
+	/// @tparam TTraits 文字列の特性
+	/// @tparam N キャプチャの数 (マッチ全体を含む)
+	template<class TChar, class TTraits, size_t N>
+	class regex_match final
+	{
+	public:
+		// --- 型エイリアス定義
+		using string_view_type = basic_string_view<TChar, TTraits>;
+		using size_type        = size_t;
+
+		// --- 定数定義
+
+		/// @brief 存在しない位置を表す値
+		static constexpr size_type npos = static_cast<size_type>(-1);
+
+		// --- コンストラクタ
+
+		/// @brief デフォルトコンストラクタ
+		/// @details マッチしなかった結果として初期化する
+		PUPPY_NODISCARD_CTOR
+		constexpr regex_match() noexcept = default;
+
+		/// @brief 照合結果を指定して初期化する
+		/// @param subject 照合した文字列
+		/// @param offsets 各キャプチャの開始位置と終了位置
+		PUPPY_NODISCARD_CTOR
+		constexpr regex_match(string_view_type subject, const std::array<size_type, N * 2>& offsets) noexcept
+			: _subject{subject}, _offsets{offsets}, _matched{true}
+		{}
+
+		// --- 演算子オーバーロード
+
+		/// @brief マッチしたかを返す
+		[[nodiscard]]
+		constexpr explicit operator bool() const noexcept
+		{
+			return _matched;
+		}
+
+		/// @brief キャプチャした文字列を返す
+		/// @param index キャプチャの番号 (0はマッチ全体)
+		/// @return キャプチャした文字列、グループが照合に参加しなかった場合は空の文字列
+		[[nodiscard]]
+		constexpr string_view_type operator[](size_type index) const noexcept
+		{
+			PUPPY_EXPECTS(index < N);
+			if (!_matched || _offsets[index * 2] == npos || _offsets[index * 2 + 1] == npos)
+			{
+				return {};
+			}
+			return _subject.substr(_offsets[index * 2], _offsets[index * 2 + 1] - _offsets[index * 2]);
+		}
+
+		// --- ゲッターメソッド
+
+		/// @brief マッチしたかを返す
+		[[nodiscard]]
+		constexpr bool matched() const noexcept
+		{
+			return _matched;
+		}
+
+		/// @brief キャプチャの数を返す
+		[[nodiscard]]
+		static constexpr size_type size() noexcept
+		{
+			return N;
+		}
+
+		/// @brief キャプチャした文字列を返す
+		/// @tparam I キャプチャの番号 (0はマッチ全体)
+		template<size_type I>
+		[[nodiscard]]
+		constexpr string_view_type get() const noexcept
+		{
+			static_assert(I < N, "Capture index out of range.");
+			return (*this)[I];
+		}
+
+		/// @brief キャプチャの開始位置を返す
+		/// @param index キャプチャの番号 (0はマッチ全体)
+		/// @return 照合した文字列の先頭からの位置、グループが照合に参加しなかった場合はnpos
+		[[nodiscard]]
+		constexpr size_type position(size_type index = 0) const noexcept
+		{
+			PUPPY_EXPECTS(index < N);
+			return _matched ? _offsets[index * 2] : npos;
+		}
+
+		/// @brief キャプチャの長さを返す
+		/// @param index キャプチャの番号 (0はマッチ全体)
+		[[nodiscard]]
+		constexpr size_type length(size_type index = 0) const noexcept
+		{
+			return (*this)[index].size();
+		}
+
+		/// @brief 照合した文字列を返す
+		[[nodiscard]]
+		constexpr string_view_type subject() const noexcept
+		{
+			return _subject;
+		}
+
+	private:
+		// --- メンバ変数定義
+		string_view_type _subject;
+		std::array<size_type, N * 2> _offsets{};
+		bool _matched = false;
+	};
+
+	/// @brief 文字列中の重ならないマッチを先頭から順に遅延評価で列挙する範囲
+	/// @tparam TRegex 正規表現の型
+	/// @tparam TChar 文字列の文字型
+	/// @tparam TTraits 文字列の特性
+	template<class TRegex, class TChar, class TTraits>
+	class regex_match_view final
+		: public std::ranges::view_interface<regex_match_view<TRegex, TChar, TTraits>>
+	{
+	public:
+		// --- 型エイリアス定義
+		using string_view_type = basic_string_view<TChar, TTraits>;
+		using match_type       = regex_match<TChar, TTraits, TRegex::capture_count>;
+
+		/// @brief マッチを列挙するイテレータ
+		class iterator final
+		{
+		public:
+			// --- 型エイリアス定義
+			using iterator_concept = std::input_iterator_tag;
+			using value_type       = match_type;
+			using difference_type  = ptrdiff_t;
+
+			// --- コンストラクタ
+			PUPPY_NODISCARD_CTOR
+			constexpr iterator() noexcept = default;
+
+			PUPPY_NODISCARD_CTOR
+			constexpr iterator(string_view_type subject, const match_type& current) noexcept
+				: _subject{subject}, _current{current}
+			{}
+
+			// --- 演算子オーバーロード
+			[[nodiscard]]
+			constexpr const match_type& operator*() const noexcept
+			{
+				return _current;
+			}
+
+			[[nodiscard]]
+			constexpr const match_type* operator->() const noexcept
+			{
+				return &_current;
+			}
+
+			constexpr iterator& operator++() noexcept
+			{
+				PUPPY_EXPECTS(_current.matched());
+				// 空文字列にマッチした場合は無限に同じ位置でマッチしないよう1文字進める
+				size_t next = _current.position() + _current.length();
+				if (_current.length() == 0 && next++ == _subject.size())
+				{
+					_current = {};
+					return *this;
+				}
+				_current = TRegex::search(_subject, next);
+				return *this;
+			}
+
+			constexpr void operator++(int) noexcept
+			{
+				++*this;
+			}
+
+			[[nodiscard]]
+			friend constexpr bool operator==(const iterator& it, std::default_sentinel_t) noexcept
+			{
+				return !it._current.matched();
+			}
+
+		private:
+			// --- メンバ変数定義
+			string_view_type _subject;
+			match_type _current;
+		};
+
+		// --- コンストラクタ
+		PUPPY_NODISCARD_CTOR
+		constexpr regex_match_view() noexcept = default;
+
+		PUPPY_NODISCARD_CTOR
+		constexpr explicit regex_match_view(string_view_type subject) noexcept
+			: _subject{subject}
+		{}
+
+		// --- イテレータ
+		[[nodiscard]]
+		constexpr iterator begin() const noexcept
+		{
+			return {_subject, TRegex::search(_subject)};
+		}
+
+		[[nodiscard]]
+		constexpr std::default_sentinel_t end() const noexcept
+		{
+			return std::default_sentinel;
+		}
+
+	private:
+		// --- メンバ変数定義
+		string_view_type _subject;
+	};
+
+	/// @brief パターンの構文エラー (エラーがなければregex_error::none)
+	template<fixed_string Pattern>
+	inline constexpr regex_error regex_pattern_error = detail::regex_engine<Pattern>::sizes.error;
+
+	/// @brief コンパイル時に解析される正規表現
+	/// @details パターンはコンパイル時にプログラムへ変換され、構文エラーはコンパイルエラーになる。
+	///          全ての照合は定数式の中でも実行できる。
+	/// @tparam Pattern ECMAScript風のパターン
+	template<fixed_string Pattern>
+	class regex final
+	{
+		using engine = detail::regex_engine<Pattern>;
+		static_assert(engine::sizes.error == regex_error::none, "Invalid regular expression pattern.");
+
+	public:
+		// --- 定数定義
+
+		/// @brief キャプチャの数 (マッチ全体を含む)
+		static constexpr size_t capture_count = engine::sizes.capture_count;
+
+		/// @brief 真偽判定にDFAを使うか
+		static constexpr bool uses_dfa = engine::has_dfa;
+
+		// --- 照合メソッド
+
+		/// @brief 文字列全体がパターンに一致するかを返す
+		/// @param str 照合する文字列
+		template<class TChar, class TTraits>
+		[[nodiscard]]
+		static constexpr bool matches(basic_string_view<TChar, TTraits> str) noexcept
+		{
+			if constexpr (engine::has_dfa)
+			{
+				return engine::dfa_matches(str);
+			}
+			else
+			{
+				typename engine::slots_type slots{};
+				return engine::execute(str, 0, true, slots);
+			}
+		}
+
+		/// @brief 文字列中にパターンに一致する部分が存在するかを返す
+		/// @param str 照合する文字列
+		template<class TChar, class TTraits>
+		[[nodiscard]]
+		static constexpr bool contains(basic_string_view<TChar, TTraits> str) noexcept
+		{
+			if constexpr (engine::has_dfa)
+			{
+				return engine::dfa_contains(str);
+			}
+			else
+			{
+				typename engine::slots_type slots{};
+				return engine::execute(str, 0, false, slots);
+			}
+		}
+
+		/// @brief 文字列全体をパターンと照合する
+		/// @param str 照合する文字列
+		/// @return 照合結果
+		template<class TChar, class TTraits>
+		[[nodiscard]]
+		static constexpr regex_match<TChar, TTraits, capture_count>
+		match(basic_string_view<TChar, TTraits> str) noexcept
+		{
+			typename engine::slots_type slots{};
+			if constexpr (engine::has_dfa && capture_count == 1)
+			{
+				if (!engine::dfa_matches(str))
+				{
+					return {};
+				}
+				slots = {0, str.size()};
+			}
+			else if (!engine::execute(str, 0, true, slots))
+			{
+				return {};
+			}
+			return {str, slots};
+		}
+
+		/// @brief 文字列中で最も左にあるマッチを探す
+		/// @param str 照合する文字列
+		/// @param position 探索を開始する位置
+		/// @return 照合結果
+		template<class TChar, class TTraits>
+		[[nodiscard]]
+		static constexpr regex_match<TChar, TTraits, capture_count>
+		search(basic_string_view<TChar, TTraits> str, size_t position = 0) noexcept
+		{
+			PUPPY_EXPECTS(position <= str.size());
+			typename engine::slots_type slots{};
+			if (!engine::execute(str, position, false, slots))
+			{
+				return {};
+			}
+			return {str, slots};
+		}
+
+		/// @brief 文字列中の重ならないマッチを全て列挙する
+		/// @param str 照合する文字列
+		/// @return マッチを遅延評価で列挙する範囲
+		template<class TChar, class TTraits>
+		[[nodiscard]]
+		static constexpr regex_match_view<regex, TChar, TTraits>
+		find_all(basic_string_view<TChar, TTraits> str) noexcept
+		{
+			return regex_match_view<regex, TChar, TTraits>{str};
+		}
+	};
+}
+
+#endif // _PUPPY_REGEX_HPP
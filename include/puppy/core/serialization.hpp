@@ -0,0 +1,690 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#ifndef _PUPPY_SERIALIZATION_HPP
+#define _PUPPY_SERIALIZATION_HPP
+
+#include "common.hpp"
+#include "contracts.hpp"
+#include "reflection.hpp"
+#include "string_view.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// バイナリレイアウト
+//
+// [header]  serialized_header (24バイト)
+// [record]  u32 field_count, u32 field_offsets[field_count], インライン領域...
+//
+// - field_offsetsはレコード先頭からの相対位置で、0はフィールドが存在しないことを表す
+// - スカラはインライン領域に自身のアラインメントで格納される
+// - 文字列は {u32 offset, u32 length}、配列は {u32 offset, u32 count}、
+//   ネストしたレコードは {u32 offset} としてインライン領域に格納され、
+//   offsetはバッファ先頭からの絶対位置を指す
+// - 文字列の末尾にはヌル文字が書き込まれる
+
+namespace puppy
+{
+	/// @brief シリアライズされたバッファの検証結果
+	enum class serialized_status : std::uint8_t
+	{
+		ok,                  ///< 正常
+		too_small,           ///< バッファがヘッダより小さい
+		misaligned,          ///< バッファのアラインメントが不正
+		bad_magic,           ///< マジックナンバーが一致しない
+		unsupported_format,  ///< 対応していないフォーマットのバージョン
+		endian_mismatch,     ///< エンディアンが一致しない
+		truncated,           ///< バッファがヘッダに記録されたサイズより小さい
+		bad_root,            ///< ルートレコードの位置が不正
+		checksum_mismatch,   ///< チェックサムが一致しない
+	};
+
+	/// @brief シリアライズのオプション
+	struct serialize_options final
+	{
+		/// @brief チェックサムを書き込むか
+		bool checksum = true;
+	};
+
+	/// @brief バッファに要求されるアラインメント
+	inline constexpr size_t serialized_alignment = 8;
+
+	/// @brief CRC-32C (Castagnoli) を計算する
+	/// @param data 対象のバイト列
+	/// @param crc 前回までの計算結果
+	/// @return 計算結果
+	[[nodiscard]]
+	PUPPY_EXPORT std::uint32_t crc32c(std::span<const byte_t> data, std::uint32_t crc = 0) noexcept;
+
+	/// @brief シリアライズされたバッファを検証する
+	/// @param buffer 検証するバッファ
+	/// @param verify_checksum チェックサムを検証するか
+	/// @return 検証結果
+	/// @note レコード内部のオフセットまでは検証しない
+	[[nodiscard]]
+	PUPPY_EXPORT serialized_status verify_serialized(
+		std::span<const byte_t> buffer, bool verify_checksum = true) noexcept;
+
+	template<reflectable T>
+	class serialized;
+
+	template<class TElement>
+	class serialized_array;
+}
+
+namespace puppy::detail
+{
+	// --- ヘッダ定義
+	struct serialized_header final
+	{
+		std::uint32_t magic;
+		std::uint16_t format;
+		std::uint16_t flags;
+		std::uint32_t schema_version;
+		std::uint32_t size;
+		std::uint32_t checksum;
+		std::uint32_t root;
+	};
+	static_assert(sizeof(serialized_header) == 24);
+
+	inline constexpr std::uint32_t serialized_magic         = 0x53595050; // "PPYS"
+	inline constexpr std::uint16_t serialized_format        = 1;
+	inline constexpr std::uint16_t serialized_flag_checksum = 1 << 0;
+	inline constexpr std::uint16_t serialized_flag_big      = 1 << 1;
+
+	/// @brief ヘッダを書き込み、バッファを完成させる
+	PUPPY_EXPORT void finish_serialized(std::span<byte_t> buffer,
+		std::uint32_t root, std::uint32_t schema_version, bool checksum) noexcept;
+
+	// --- 読み込み対象のバッファ
+	struct serialized_buffer final
+	{
+		const byte_t* data = nullptr;
+		size_t size = 0;
+
+		template<class T>
+		[[nodiscard]]
+		PUPPY_FORCE_INLINE
+		T load(size_t pos) const noexcept
+		{
+			PUPPY_ASSERT(pos + sizeof(T) <= size);
+			T value;
+			std::memcpy(&value, data + pos, sizeof(T));
+			return value;
+		}
+	};
+
+	// --- 書き込み
+	class serial_writer final
+	{
+	public:
+		/// @brief 書き込み位置をアラインメントに揃える
+		size_t align(size_t alignment)
+		{
+			const size_t pos = (_buffer.size() + alignment - 1) & ~(alignment - 1);
+			_buffer.resize(pos);
+			return pos;
+		}
+
+		/// @brief ゼロで埋めた領域を確保する
+		size_t reserve(size_t bytes)
+		{
+			const size_t pos = _buffer.size();
+			PUPPY_EXPECTS(pos + bytes <= std::numeric_limits<std::uint32_t>::max());
+			_buffer.resize(pos + bytes);
+			return pos;
+		}
+
+		/// @brief 確保済みの領域に値を書き込む
+		template<class T>
+		void store(size_t pos, const T& value) noexcept
+		{
+			PUPPY_ASSERT(pos + sizeof(T) <= _buffer.size());
+			std::memcpy(_buffer.data() + pos, &value, sizeof(T));
+		}
+
+		/// @brief 確保済みの領域にバイト列を書き込む
+		void store_bytes(size_t pos, const void* bytes, size_t count) noexcept
+		{
+			PUPPY_ASSERT(pos + count <= _buffer.size());
+			if (count != 0)
+			{
+				std::memcpy(_buffer.data() + pos, bytes, count);
+			}
+		}
+
+		[[nodiscard]]
+		std::vector<byte_t> release() noexcept
+		{
+			return std::move(_buffer);
+		}
+
+	private:
+		std::vector<byte_t> _buffer;
+	};
+
+	// --- 型ごとの格納方法
+	template<class T>
+	struct serial_traits;
+
+	template<class T>
+	struct serial_string_char;
+
+	template<class TChar, class TTraits, class TAlloc>
+	struct serial_string_char<std::basic_string<TChar, TTraits, TAlloc>>
+	{
+		using type = TChar;
+	};
+
+	template<class TChar, class TTraits>
+	struct serial_string_char<std::basic_string_view<TChar, TTraits>>
+	{
+		using type = TChar;
+	};
+
+	template<class TChar, class TTraits>
+	struct serial_string_char<basic_string_view<TChar, TTraits>>
+	{
+		using type = TChar;
+	};
+
+	template<class T>
+	struct serial_vector_element;
+
+	template<class TElement, class TAlloc>
+	struct serial_vector_element<std::vector<TElement, TAlloc>>
+	{
+		using type = TElement;
+	};
+
+	template<class T>
+	concept serial_scalar = (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+		&& alignof(T) <= serialized_alignment;
+
+	template<class T>
+	concept serial_string = requires { typename serial_string_char<T>::type; };
+
+	template<class T>
+	concept serial_vector = requires { typename serial_vector_element<T>::type; };
+
+	template<class T>
+	concept serializable = requires { typename serial_traits<T>::view_type; };
+
+	PUPPY_FORCE_INLINE
+	std::uint32_t to_offset(size_t pos) noexcept
+	{
+		return static_cast<std::uint32_t>(pos);
+	}
+
+	template<reflectable T>
+	size_t write_record(serial_writer& writer, const T& object);
+
+	template<serial_scalar T>
+	struct serial_traits<T>
+	{
+		using view_type = T;
+
+		static constexpr size_t inline_size  = sizeof(T);
+		static constexpr size_t inline_align = alignof(T);
+
+		static void write_inline(serial_writer& writer, size_t slot, const T& value) noexcept
+		{
+			writer.store(slot, value);
+		}
+
+		static void write_out_of_line(serial_writer&, size_t, const T&) noexcept
+		{}
+
+		[[nodiscard]]
+		static view_type read(serialized_buffer buffer, size_t slot) noexcept
+		{
+			return buffer.load<T>(slot);
+		}
+	};
+
+	template<serial_string T>
+	struct serial_traits<T>
+	{
+		using char_type = typename serial_string_char<T>::type;
+		using view_type = basic_string_view<char_type>;
+
+		static constexpr size_t inline_size  = sizeof(std::uint32_t) * 2;
+		static constexpr size_t inline_align = alignof(std::uint32_t);
+
+		static void write_inline(serial_writer&, size_t, const T&) noexcept
+		{}
+
+		static void write_out_of_line(serial_writer& writer, size_t slot, const T& value)
+		{
+			const size_t length = value.size();
+			writer.align(alignof(char_type));
+			const size_t pos = writer.reserve((length + 1) * sizeof(char_type));
+			writer.store_bytes(pos, value.data(), length * sizeof(char_type));
+			writer.store(slot, to_offset(pos));
+			writer.store(slot + sizeof(std::uint32_t), static_cast<std::uint32_t>(length));
+		}
+
+		[[nodiscard]]
+		static view_type read(serialized_buffer buffer, size_t slot) noexcept
+		{
+			const auto offset = buffer.load<std::uint32_t>(slot);
+			const auto length = buffer.load<std::uint32_t>(slot + sizeof(std::uint32_t));
+			if (offset == 0)
+			{
+				return {};
+			}
+			PUPPY_ASSERT(offset + (size_t{length} + 1) * sizeof(char_type) <= buffer.size);
+			return {reinterpret_cast<const char_type*>(buffer.data + offset), length};
+		}
+	};
+
+	template<reflectable T>
+	struct serial_traits<T>
+	{
+		using view_type = serialized<T>;
+
+		static constexpr size_t inline_size  = sizeof(std::uint32_t);
+		static constexpr size_t inline_align = alignof(std::uint32_t);
+
+		static void write_inline(serial_writer&, size_t, const T&) noexcept
+		{}
+
+		static void write_out_of_line(serial_writer& writer, size_t slot, const T& value)
+		{
+			writer.store(slot, to_offset(write_record(writer, value)));
+		}
+
+		[[nodiscard]]
+		static view_type read(serialized_buffer buffer, size_t slot) noexcept
+		{
+			const auto offset = buffer.load<std::uint32_t>(slot);
+			return offset == 0 ? view_type{} : view_type{buffer, offset};
+		}
+	};
+
+	template<serial_vector T>
+	requires serializable<typename serial_vector_element<T>::type>
+	struct serial_traits<T>
+	{
+		using element_type = typename serial_vector_element<T>::type;
+		using element_traits = serial_traits<element_type>;
+		using view_type = serialized_array<element_type>;
+
+		static constexpr size_t inline_size  = sizeof(std::uint32_t) * 2;
+		static constexpr size_t inline_align = alignof(std::uint32_t);
+
+		static void write_inline(serial_writer&, size_t, const T&) noexcept
+		{}
+
+		static void write_out_of_line(serial_writer& writer, size_t slot, const T& value)
+		{
+			const size_t count = value.size();
+			const size_t pos = writer.align(std::max(element_traits::inline_align, alignof(std::uint32_t)));
+			writer.reserve(count * element_traits::inline_size);
+			// std::vector<bool>は連続した領域を持たないため、他の要素型と同じく1要素ずつ書き込む
+			if constexpr (serial_scalar<element_type> && !std::is_same_v<element_type, bool>)
+			{
+				writer.store_bytes(pos, value.data(), count * sizeof(element_type));
+			}
+			else
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					element_traits::write_inline(writer, pos + i * element_traits::inline_size, value[i]);
+				}
+				for (size_t i = 0; i < count; ++i)
+				{
+					element_traits::write_out_of_line(writer, pos + i * element_traits::inline_size, value[i]);
+				}
+			}
+			writer.store(slot, to_offset(pos));
+			writer.store(slot + sizeof(std::uint32_t), static_cast<std::uint32_t>(count));
+		}
+
+		[[nodiscard]]
+		static view_type read(serialized_buffer buffer, size_t slot) noexcept
+		{
+			const auto offset = buffer.load<std::uint32_t>(slot);
+			const auto count = buffer.load<std::uint32_t>(slot + sizeof(std::uint32_t));
+			if (offset == 0)
+			{
+				return {};
+			}
+			PUPPY_ASSERT(offset + size_t{count} * element_traits::inline_size <= buffer.size);
+			return {buffer, offset, count};
+		}
+	};
+
+	template<reflectable T>
+	size_t write_record(serial_writer& writer, const T& object)
+	{
+		constexpr size_t field_count = descriptor_v<T>.field_count;
+
+		const size_t record = writer.align(alignof(std::uint32_t));
+		writer.reserve(sizeof(std::uint32_t) * (field_count + 1));
+		writer.store(record, static_cast<std::uint32_t>(field_count));
+
+		// インライン領域を書き込み、フィールドの位置を記録する
+		std::array<size_t, field_count> slots{};
+		for_each_field(object, [&](const auto&, const auto& member, auto index)
+		{
+			using traits = serial_traits<std::remove_cvref_t<decltype(member)>>;
+			const size_t slot = writer.align(traits::inline_align);
+			writer.reserve(traits::inline_size);
+			traits::write_inline(writer, slot, member);
+			writer.store(record + sizeof(std::uint32_t) * (index + 1), to_offset(slot - record));
+			slots[index] = slot;
+		});
+
+		// 文字列や配列などの本体を書き込む
+		for_each_field(object, [&](const auto&, const auto& member, auto index)
+		{
+			using traits = serial_traits<std::remove_cvref_t<decltype(member)>>;
+			traits::write_out_of_line(writer, slots[index], member);
+		});
+
+		return record;
+	}
+}
+
+namespace puppy
+{
+	/// @brief シリアライズされたレコードをバッファ上で直接参照するクラス
+	/// @tparam T PUPPY_REFLECTで記述された型
+	/// @details 値のコピーや構文解析を行わず、バッファ上のデータを直接返す
+	template<reflectable T>
+	class serialized final
+	{
+	public:
+		// --- 型エイリアス定義
+		using value_type = T;
+
+		// --- コンストラクタ
+
+		/// @brief デフォルトコンストラクタ
+		/// @details レコードを参照しない状態で初期化する
+		PUPPY_NODISCARD_CTOR
+		constexpr serialized() noexcept = default;
+
+		/// @brief バッファとレコードの位置を指定して初期化する
+		/// @param buffer 参照するバッファ
+		/// @param offset レコードの位置
+		PUPPY_NODISCARD_CTOR
+		serialized(detail::serialized_buffer buffer, size_t offset) noexcept
+			: _buffer{buffer}, _offset{offset}
+		{
+			PUPPY_ASSERT(offset % alignof(std::uint32_t) == 0);
+		}
+
+		// --- ゲッターメソッド
+
+		/// @brief レコードを参照しているかを返す
+		[[nodiscard]]
+		constexpr bool valid() const noexcept
+		{
+			return _buffer.data != nullptr;
+		}
+
+		/// @brief 書き込まれたフィールドの数を返す
+		/// @return 書き込まれたフィールドの数
+		[[nodiscard]]
+		size_t field_count() const noexcept
+		{
+			return valid() ? _buffer.load<std::uint32_t>(_offset) : 0;
+		}
+
+		/// @brief フィールドが書き込まれているかを返す
+		/// @tparam Member メンバへのポインタ
+		/// @return フィールドが書き込まれているか
+		/// @details 古いスキーマで書き込まれたバッファには新しいフィールドが存在しない
+		template<auto Member>
+		[[nodiscard]]
+		bool has() const noexcept
+		{
+			return slot(field_index_of<Member>()) != 0;
+		}
+
+		/// @brief フィールドの値を返す
+		/// @tparam Member メンバへのポインタ
+		/// @return フィールドの値 書き込まれていなければ値初期化された値
+		/// @details 文字列はbasic_string_view、配列はserialized_array、
+		///          ネストしたレコードはserializedとしてバッファを直接参照する
+		template<auto Member>
+		[[nodiscard]]
+		auto get() const noexcept
+		{
+			constexpr size_t index = field_index_of<Member>();
+			using field_type = std::remove_cvref_t<decltype(std::get<index>(descriptor_v<T>.fields))>;
+			using traits = detail::serial_traits<typename field_type::member_type>;
+
+			const size_t pos = slot(index);
+			if (pos == 0)
+			{
+				return typename traits::view_type{};
+			}
+			return traits::read(_buffer, _offset + pos);
+		}
+
+	private:
+		// --- メンバ関数定義
+
+		template<auto Member>
+		static consteval size_t field_index_of() noexcept
+		{
+			constexpr size_t index = field_index<T, Member>();
+			static_assert(index < descriptor_v<T>.field_count, "Member is not described by PUPPY_REFLECT.");
+			return index;
+		}
+
+		[[nodiscard]]
+		size_t slot(size_t index) const noexcept
+		{
+			if (index >= field_count())
+			{
+				return 0;
+			}
+			return _buffer.load<std::uint32_t>(_offset + sizeof(std::uint32_t) * (index + 1));
+		}
+
+		// --- メンバ変数定義
+
+		detail::serialized_buffer _buffer;
+		size_t _offset = 0;
+	};
+
+	/// @brief シリアライズされた配列をバッファ上で直接参照するクラス
+	/// @tparam TElement 要素の型
+	template<class TElement>
+	class serialized_array final
+	{
+		using traits = detail::serial_traits<TElement>;
+
+	public:
+		// --- 型エイリアス定義
+		using value_type = typename traits::view_type;
+		using size_type  = size_t;
+
+		/// @brief 要素を順に参照するイテレータ
+		/// @details バッファと配列の位置を値として持つため、一時的なserialized_arrayより長く使える
+		class const_iterator final
+		{
+		public:
+			using iterator_concept = std::forward_iterator_tag;
+			using value_type       = serialized_array::value_type;
+			using difference_type  = ptrdiff_t;
+
+			constexpr const_iterator() noexcept = default;
+
+			constexpr const_iterator(detail::serialized_buffer buffer, size_t offset, size_type index) noexcept
+				: _buffer{buffer}, _offset{offset}, _index{index}
+			{}
+
+			[[nodiscard]]
+			value_type operator*() const noexcept
+			{
+				return traits::read(_buffer, _offset + _index * traits::inline_size);
+			}
+
+			const_iterator& operator++() noexcept
+			{
+				++_index;
+				return *this;
+			}
+
+			const_iterator operator++(int) noexcept
+			{
+				auto temp = *this;
+				++_index;
+				return temp;
+			}
+
+			[[nodiscard]]
+			constexpr bool operator==(const const_iterator& rhs) const noexcept
+			{
+				return _index == rhs._index;
+			}
+
+		private:
+			detail::serialized_buffer _buffer;
+			size_t _offset = 0;
+			size_type _index = 0;
+		};
+
+		// --- コンストラクタ
+
+		/// @brief デフォルトコンストラクタ
+		/// @details 空の配列として初期化する
+		PUPPY_NODISCARD_CTOR
+		constexpr serialized_array() noexcept = default;
+
+		/// @brief バッファと配列の位置を指定して初期化する
+		/// @param buffer 参照するバッファ
+		/// @param offset 配列の位置
+		/// @param size 要素数
+		PUPPY_NODISCARD_CTOR
+		constexpr serialized_array(detail::serialized_buffer buffer, size_t offset, size_type size) noexcept
+			: _buffer{buffer}, _offset{offset}, _size{size}
+		{}
+
+		// --- ゲッターメソッド
+
+		[[nodiscard]]
+		const_iterator begin() const noexcept
+		{
+			return {_buffer, _offset, 0};
+		}
+
+		[[nodiscard]]
+		const_iterator end() const noexcept
+		{
+			return {_buffer, _offset, _size};
+		}
+
+		[[nodiscard]]
+		PUPPY_FORCE_INLINE
+		constexpr size_type size() const noexcept
+		{
+			return _size;
+		}
+
+		[[nodiscard]]
+		PUPPY_FORCE_INLINE
+		constexpr bool empty() const noexcept
+		{
+			return _size == 0;
+		}
+
+		/// @brief スカラの配列をspanとして返す
+		/// @return バッファ上の配列を指すspan
+		[[nodiscard]]
+		std::span<const TElement> span() const noexcept
+		requires detail::serial_scalar<TElement>
+		{
+			if (_size == 0)
+			{
+				return {};
+			}
+			return {reinterpret_cast<const TElement*>(_buffer.data + _offset), _size};
+		}
+
+		// --- 要素アクセスメソッド
+
+		/// @brief 任意の位置の要素を返す
+		/// @param index 要素の位置
+		/// @return 任意の位置の要素
+		[[nodiscard]]
+		value_type operator[](size_type index) const noexcept
+		{
+			PUPPY_ASSERT(index < _size);
+			return traits::read(_buffer, _offset + index * traits::inline_size);
+		}
+
+	private:
+		// --- メンバ変数定義
+
+		detail::serialized_buffer _buffer;
+		size_t _offset = 0;
+		size_type _size = 0;
+	};
+
+	/// @brief 値をバイナリ形式にシリアライズする
+	/// @param value シリアライズする値
+	/// @param options シリアライズのオプション
+	/// @return シリアライズされたバッファ
+	template<reflectable T>
+	[[nodiscard]]
+	std::vector<byte_t> serialize(const T& value, const serialize_options& options = {})
+	{
+		detail::serial_writer writer;
+		writer.reserve(sizeof(detail::serialized_header));
+		const size_t root = detail::write_record(writer, value);
+		writer.align(serialized_alignment);
+
+		auto buffer = writer.release();
+		detail::finish_serialized(buffer, detail::to_offset(root), descriptor_v<T>.version, options.checksum);
+		return buffer;
+	}
+
+	/// @brief シリアライズされたバッファのスキーマのバージョンを返す
+	/// @param buffer verify_serializedで検証済みのバッファ
+	/// @return スキーマのバージョン
+	[[nodiscard]]
+	inline std::uint32_t serialized_schema_version(std::span<const byte_t> buffer) noexcept
+	{
+		PUPPY_EXPECTS(buffer.size() >= sizeof(detail::serialized_header));
+		const detail::serialized_buffer view{buffer.data(), buffer.size()};
+		return view.load<std::uint32_t>(offsetof(detail::serialized_header, schema_version));
+	}
+
+	/// @brief シリアライズされたバッファのルートレコードを返す
+	/// @param buffer verify_serializedで検証済みのバッファ
+	/// @return ルートレコードを参照するserialized
+	/// @details バッファはメモリマップしたファイルでもよく、戻り値はバッファを直接参照する
+	template<reflectable T>
+	[[nodiscard]]
+	serialized<T> serialized_root(std::span<const byte_t> buffer) noexcept
+	{
+		PUPPY_EXPECTS(buffer.size() >= sizeof(detail::serialized_header));
+		PUPPY_EXPECTS(reinterpret_cast<std::uintptr_t>(buffer.data()) % serialized_alignment == 0);
+		const detail::serialized_buffer view{buffer.data(), buffer.size()};
+		return {view, view.load<std::uint32_t>(offsetof(detail::serialized_header, root))};
+	}
+}
+
+#endif // _PUPPY_SERIALIZATION_HPP
@@ -0,0 +1,585 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#ifndef _PUPPY_STRING_SORT_HPP
+#define _PUPPY_STRING_SORT_HPP
+
+#include "common.hpp"
+#include "contracts.hpp"
+#include "string_view.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace puppy::detail
+{
+	/// @brief 文字の数値順で比較できる文字型と特性の組み合わせであるか
+	template<class TChar, class TTraits>
+	concept radix_sortable = std::is_same_v<TTraits, std::char_traits<TChar>>
+		&& (std::is_same_v<TChar, char> || std::is_same_v<TChar, wchar_t>
+		 || std::is_same_v<TChar, char8_t> || std::is_same_v<TChar, char16_t>
+		 || std::is_same_v<TChar, char32_t>);
+
+	/// @brief 文字列の一部を64ビットの整数にまとめたキー
+	/// @details 整数として比較した結果が、文字列として比較した結果と一致するように
+	///          上位ビットから順に文字を詰め、文字列の末尾以降は0で埋める
+	template<class TChar>
+	struct string_key final
+	{
+		/// @brief 1つのキーに含まれる文字数
+		static constexpr size_t length = sizeof(std::uint64_t) / sizeof(TChar);
+		static constexpr unsigned bits = sizeof(TChar) * 8;
+
+		[[nodiscard]]
+		PUPPY_FORCE_INLINE
+		static std::uint64_t digit(TChar c) noexcept
+		{
+			using unsigned_type = std::make_unsigned_t<TChar>;
+			auto value = static_cast<unsigned_type>(c);
+			// char_traits<char>はunsigned charとして比較するが、それ以外の符号付き型は符号付きで比較する
+			if constexpr (std::is_signed_v<TChar> && !std::is_same_v<TChar, char>)
+			{
+				value ^= unsigned_type{1} << (bits - 1);
+			}
+			return value;
+		}
+
+		template<class TTraits>
+		[[nodiscard]]
+		static std::uint64_t make(basic_string_view<TChar, TTraits> str, size_t depth) noexcept
+		{
+			const TChar* data = str.data();
+			const size_t size = str.size();
+
+			std::uint64_t key = 0;
+			if (depth + length <= size) PUPPY_LIKELY
+			{
+				for (size_t i = 0; i < length; ++i)
+				{
+					key = key << bits | digit(data[depth + i]);
+				}
+				return key;
+			}
+			for (size_t i = 0; i < length; ++i)
+			{
+				key = key << bits | (depth + i < size ? digit(data[depth + i]) : 0);
+			}
+			return key;
+		}
+	};
+
+	/// @brief タスクを複数のスレッドで処理する
+	/// @param thread_count スレッド数
+	/// @param task_count タスク数
+	/// @param func タスクの番号を受け取る関数
+	template<class TFunc>
+	void parallel_for(size_t thread_count, size_t task_count, TFunc&& func)
+	{
+		std::atomic<size_t> next{0};
+		const auto worker = [&]
+		{
+			for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < task_count;)
+			{
+				func(i);
+			}
+		};
+
+		std::vector<std::jthread> threads;
+		threads.reserve(thread_count - 1);
+		for (size_t i = 1; i < std::min(thread_count, task_count); ++i)
+		{
+			threads.emplace_back(worker);
+		}
+		worker();
+	}
+
+	/// @brief キャッシュしたキーによるMSD基数ソート
+	template<class TChar, class TTraits>
+	class string_sorter final
+	{
+	public:
+		// --- 型エイリアス定義
+		using view_type = basic_string_view<TChar, TTraits>;
+		using key_type  = string_key<TChar>;
+
+		// --- 定数定義
+
+		/// @brief 挿入ソートに切り替える要素数
+		static constexpr size_t insertion_threshold = 24;
+		/// @brief マルチキークイックソートに切り替える要素数
+		static constexpr size_t radix_threshold = 512;
+		/// @brief 並列化する要素数
+		static constexpr size_t parallel_threshold = size_t{1} << 16;
+
+		// --- コンストラクタ
+
+		PUPPY_NODISCARD_CTOR
+		explicit string_sorter(std::span<view_type> views)
+			: _views{views.data()}
+			, _keys(views.size())
+			, _tmp_views(views.size())
+			, _tmp_keys(views.size())
+		{}
+
+		PUPPY_NOT_COPYABLE(string_sorter);
+		PUPPY_NOT_MOVEABLE(string_sorter);
+
+		// --- ソート
+
+		/// @brief 先頭depth文字が共通する範囲をソートする
+		void sort(size_t first, size_t last, size_t depth)
+		{
+			while (last - first > 1)
+			{
+				compute_keys(first, last, depth);
+				if (!all_keys_equal(first, last))
+				{
+					sort_keys(first, last, 0);
+					sort_equal_runs(first, last, depth);
+					return;
+				}
+				// キーがすべて等しければ、次のキーへ進む
+				first = move_ended_to_front(first, last, depth + key_type::length);
+				depth += key_type::length;
+			}
+		}
+
+		/// @brief 全体を複数のスレッドでソートする
+		void parallel_sort(size_t size, size_t thread_count)
+		{
+			size_t first = 0;
+			size_t depth = 0;
+			while (size - first >= parallel_threshold)
+			{
+				const size_t chunk_count = thread_count;
+				const auto chunk = [&](size_t i)
+				{
+					return first + (size - first) * i / chunk_count;
+				};
+
+				parallel_for(thread_count, chunk_count, [&](size_t i)
+				{
+					compute_keys(chunk(i), chunk(i + 1), depth);
+				});
+
+				// キーの上位バイトから、値が分かれる最初のバイトを探す
+				std::vector<std::array<size_t, 256>> counts(chunk_count);
+				for (unsigned byte = 0; byte < 8; ++byte)
+				{
+					const unsigned shift = 56 - byte * 8;
+					parallel_for(thread_count, chunk_count, [&](size_t i)
+					{
+						counts[i].fill(0);
+						for (size_t j = chunk(i); j < chunk(i + 1); ++j)
+						{
+							++counts[i][(_keys[j] >> shift) & 0xFF];
+						}
+					});
+
+					// バケットごとの書き込み位置を求める
+					std::array<size_t, 257> buckets{};
+					std::vector<std::array<size_t, 256>> offsets(chunk_count);
+					size_t offset = first;
+					for (size_t bucket = 0; bucket < 256; ++bucket)
+					{
+						buckets[bucket] = offset;
+						for (size_t i = 0; i < chunk_count; ++i)
+						{
+							offsets[i][bucket] = offset;
+							offset += counts[i][bucket];
+						}
+					}
+					buckets[256] = offset;
+
+					// すべて同じバケットに入る場合は次のバイトへ進む
+					bool single = false;
+					for (size_t bucket = 0; bucket < 256; ++bucket)
+					{
+						single |= buckets[bucket + 1] - buckets[bucket] == size - first;
+					}
+					if (single)
+					{
+						continue;
+					}
+
+					// 分配し、バケットごとに並列にソートする
+					parallel_for(thread_count, chunk_count, [&](size_t i)
+					{
+						auto& positions = offsets[i];
+						for (size_t j = chunk(i); j < chunk(i + 1); ++j)
+						{
+							const size_t pos = positions[(_keys[j] >> shift) & 0xFF]++;
+							_tmp_keys[pos] = _keys[j];
+							_tmp_views[pos] = _views[j];
+						}
+					});
+					parallel_for(thread_count, chunk_count, [&](size_t i)
+					{
+						std::copy(_tmp_keys.begin() + chunk(i), _tmp_keys.begin() + chunk(i + 1), _keys.begin() + chunk(i));
+						std::copy(_tmp_views.begin() + chunk(i), _tmp_views.begin() + chunk(i + 1), _views + chunk(i));
+					});
+
+					// 大きいバケットから処理する
+					std::array<size_t, 256> order;
+					for (size_t bucket = 0; bucket < 256; ++bucket)
+					{
+						order[bucket] = bucket;
+					}
+					std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs)
+					{
+						return buckets[lhs + 1] - buckets[lhs] > buckets[rhs + 1] - buckets[rhs];
+					});
+					parallel_for(thread_count, 256, [&](size_t i)
+					{
+						const size_t bucket_first = buckets[order[i]];
+						const size_t bucket_last  = buckets[order[i] + 1];
+						if (bucket_last - bucket_first > 1)
+						{
+							sort_keys(bucket_first, bucket_last, byte + 1);
+							sort_equal_runs(bucket_first, bucket_last, depth);
+						}
+					});
+					return;
+				}
+
+				// キーがすべて等しければ、次のキーへ進む
+				first = move_ended_to_front(first, size, depth + key_type::length);
+				depth += key_type::length;
+			}
+			sort(first, size, depth);
+		}
+
+	private:
+		// --- メンバ関数定義
+
+		void compute_keys(size_t first, size_t last, size_t depth) noexcept
+		{
+			for (size_t i = first; i < last; ++i)
+			{
+				_keys[i] = key_type::make(_views[i], depth);
+			}
+		}
+
+		[[nodiscard]]
+		bool all_keys_equal(size_t first, size_t last) const noexcept
+		{
+			const auto key = _keys[first];
+			for (size_t i = first + 1; i < last; ++i)
+			{
+				if (_keys[i] != key)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		PUPPY_FORCE_INLINE
+		void swap_elements(size_t lhs, size_t rhs) noexcept
+		{
+			std::swap(_keys[lhs], _keys[rhs]);
+			std::swap(_views[lhs], _views[rhs]);
+		}
+
+		/// @brief キーの並びが等しい区間ごとに、次のキーでソートする
+		void sort_equal_runs(size_t first, size_t last, size_t depth)
+		{
+			const size_t next_depth = depth + key_type::length;
+			for (size_t run = first; run < last;)
+			{
+				size_t run_last = run + 1;
+				while (run_last < last && _keys[run_last] == _keys[run])
+				{
+					++run_last;
+				}
+				if (run_last - run > 1)
+				{
+					sort(move_ended_to_front(run, run_last, next_depth), run_last, next_depth);
+				}
+				run = run_last;
+			}
+		}
+
+		/// @brief 長さがdepth以下の文字列を先頭に集め、長さ順に並べる
+		/// @return 残りの文字列の先頭
+		/// @details キーが等しい文字列のうち、長さがdepth以下のものは短い方が小さい
+		size_t move_ended_to_front(size_t first, size_t last, size_t depth)
+		{
+			const auto middle = std::partition(_views + first, _views + last, [depth](const view_type& str)
+			{
+				return str.size() <= depth;
+			});
+			std::sort(_views + first, middle, [](const view_type& lhs, const view_type& rhs)
+			{
+				return lhs.size() < rhs.size();
+			});
+			return static_cast<size_t>(middle - _views);
+		}
+
+		/// @brief キーを上位バイトから順にソートする
+		void sort_keys(size_t first, size_t last, unsigned byte)
+		{
+			while (last - first >= radix_threshold && byte < 8)
+			{
+				const unsigned shift = 56 - byte * 8;
+
+				std::array<size_t, 256> counts{};
+				for (size_t i = first; i < last; ++i)
+				{
+					++counts[(_keys[i] >> shift) & 0xFF];
+				}
+
+				// すべて同じバケットに入る場合は分配を省く
+				if (std::find(counts.begin(), counts.end(), last - first) != counts.end())
+				{
+					++byte;
+					continue;
+				}
+
+				std::array<size_t, 257> buckets;
+				buckets[0] = first;
+				for (size_t bucket = 0; bucket < 256; ++bucket)
+				{
+					buckets[bucket + 1] = buckets[bucket] + counts[bucket];
+				}
+
+				auto positions = buckets;
+				for (size_t i = first; i < last; ++i)
+				{
+					const size_t pos = positions[(_keys[i] >> shift) & 0xFF]++;
+					_tmp_keys[pos] = _keys[i];
+					_tmp_views[pos] = _views[i];
+				}
+				std::copy(_tmp_keys.begin() + first, _tmp_keys.begin() + last, _keys.begin() + first);
+				std::copy(_tmp_views.begin() + first, _tmp_views.begin() + last, _views + first);
+
+				for (size_t bucket = 0; bucket < 256; ++bucket)
+				{
+					if (buckets[bucket + 1] - buckets[bucket] > 1)
+					{
+						sort_keys(buckets[bucket], buckets[bucket + 1], byte + 1);
+					}
+				}
+				return;
+			}
+
+			multikey_quicksort(first, last);
+		}
+
+		/// @brief キーを3分割のクイックソートでソートする
+		/// @details 等しいキーの区間は後からsort_equal_runsで次の文字へ進める
+		void multikey_quicksort(size_t first, size_t last)
+		{
+			while (last - first >= insertion_threshold)
+			{
+				// 3点の中央値をピボットにする
+				const auto a = _keys[first];
+				const auto b = _keys[first + (last - first) / 2];
+				const auto c = _keys[last - 1];
+				const auto pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+				size_t lt = first;
+				size_t gt = last;
+				for (size_t i = first; i < gt;)
+				{
+					if (_keys[i] < pivot)
+					{
+						swap_elements(lt++, i++);
+					}
+					else if (_keys[i] > pivot)
+					{
+						swap_elements(i, --gt);
+					}
+					else
+					{
+						++i;
+					}
+				}
+
+				// 小さい方を再帰し、大きい方をループで処理する
+				if (lt - first < last - gt)
+				{
+					multikey_quicksort(first, lt);
+					first = gt;
+				}
+				else
+				{
+					multikey_quicksort(gt, last);
+					last = lt;
+				}
+			}
+
+			insertion_sort(first, last);
+		}
+
+		void insertion_sort(size_t first, size_t last) noexcept
+		{
+			for (size_t i = first + 1; i < last; ++i)
+			{
+				const auto key = _keys[i];
+				const auto view = _views[i];
+				size_t j = i;
+				for (; j > first && _keys[j - 1] > key; --j)
+				{
+					_keys[j] = _keys[j - 1];
+					_views[j] = _views[j - 1];
+				}
+				_keys[j] = key;
+				_views[j] = view;
+			}
+		}
+
+		// --- メンバ変数定義
+
+		view_type* _views;
+		std::vector<std::uint64_t> _keys;
+		std::vector<view_type> _tmp_views;
+		std::vector<std::uint64_t> _tmp_keys;
+	};
+
+	/// @brief 2つの文字列の共通接頭辞の長さを返す
+	template<class TChar, class TTraits>
+	[[nodiscard]]
+	size_t common_prefix_length(basic_string_view<TChar, TTraits> lhs, basic_string_view<TChar, TTraits> rhs) noexcept
+	{
+		const size_t size = std::min(lhs.size(), rhs.size());
+		const TChar* a = lhs.data();
+		const TChar* b = rhs.data();
+
+		size_t i = 0;
+		if constexpr (radix_sortable<TChar, TTraits> && std::endian::native == std::endian::little)
+		{
+			// 8バイトずつ比較する
+			constexpr size_t step = sizeof(std::uint64_t) / sizeof(TChar);
+			for (; i + step <= size; i += step)
+			{
+				std::uint64_t x, y;
+				std::memcpy(&x, a + i, sizeof(x));
+				std::memcpy(&y, b + i, sizeof(y));
+				if (x != y)
+				{
+					return i + static_cast<size_t>(std::countr_zero(x ^ y)) / (sizeof(TChar) * 8);
+				}
+			}
+		}
+		while (i < size && TTraits::eq(a[i], b[i]))
+		{
+			++i;
+		}
+		return i;
+	}
+}
+
+namespace puppy
+{
+	/// @brief 文字列の配列を辞書順にソートする
+	/// @param strings ソートする文字列の配列
+	/// @param thread_count 使用するスレッド数 0の場合はハードウェアのスレッド数
+	/// @details 標準の文字特性を持つ文字列には、先頭の文字を64ビットのキーとして
+	///          キャッシュするMSD基数ソートを用いる。小さなバケットはマルチキークイックソート、
+	///          大きな配列は先頭のバケットごとに並列にソートする。
+	///          それ以外の文字特性ではcompareによる比較ソートを行う
+	/// @note 等しい文字列同士の順序は保存されない
+	template<class TChar, class TTraits>
+	void sort_strings(std::span<basic_string_view<TChar, TTraits>> strings, size_t thread_count = 0)
+	{
+		if (strings.size() < 2)
+		{
+			return;
+		}
+
+		if constexpr (detail::radix_sortable<TChar, TTraits>)
+		{
+			if (thread_count == 0)
+			{
+				thread_count = std::max(1u, std::thread::hardware_concurrency());
+			}
+
+			detail::string_sorter<TChar, TTraits> sorter{strings};
+			if (thread_count > 1 && strings.size() >= sorter.parallel_threshold)
+			{
+				sorter.parallel_sort(strings.size(), thread_count);
+			}
+			else
+			{
+				sorter.sort(0, strings.size(), 0);
+			}
+		}
+		else
+		{
+			std::sort(strings.begin(), strings.end(), [](const auto& lhs, const auto& rhs)
+			{
+				return lhs.compare(rhs) < 0;
+			});
+		}
+	}
+
+	/// @brief ソート済みの文字列の配列から、連続する重複を取り除く
+	/// @param strings ソート済みの文字列の配列
+	/// @return 重複を取り除いた先頭部分
+	template<class TChar, class TTraits>
+	[[nodiscard]]
+	std::span<basic_string_view<TChar, TTraits>>
+	unique_strings(std::span<basic_string_view<TChar, TTraits>> strings) noexcept
+	{
+		const auto last = std::unique(strings.begin(), strings.end(), [](const auto& lhs, const auto& rhs)
+		{
+			return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+		});
+		return strings.first(static_cast<size_t>(last - strings.begin()));
+	}
+
+	/// @brief ソート済みの文字列の配列から、隣り合う文字列の共通接頭辞の長さ (LCP配列) を求める
+	/// @param strings ソート済みの文字列の配列
+	/// @param lcp 結果を書き込む配列 lcp[0]は0、lcp[i]はstrings[i - 1]とstrings[i]の共通接頭辞の長さ
+	template<class TChar, class TTraits>
+	void lcp_array(std::span<const basic_string_view<TChar, TTraits>> strings, std::span<size_t> lcp) noexcept
+	{
+		PUPPY_EXPECTS(lcp.size() >= strings.size());
+		if (strings.empty())
+		{
+			return;
+		}
+
+		lcp[0] = 0;
+		for (size_t i = 1; i < strings.size(); ++i)
+		{
+			lcp[i] = detail::common_prefix_length(strings[i - 1], strings[i]);
+		}
+	}
+
+	/// @brief ソート済みの文字列の配列から、LCP配列を求める
+	/// @param strings ソート済みの文字列の配列
+	/// @return LCP配列
+	template<class TChar, class TTraits>
+	[[nodiscard]]
+	std::vector<size_t> lcp_array(std::span<const basic_string_view<TChar, TTraits>> strings)
+	{
+		std::vector<size_t> lcp(strings.size());
+		lcp_array(strings, std::span{lcp});
+		return lcp;
+	}
+
+	template<class TChar, class TTraits>
+	[[nodiscard]]
+	std::vector<size_t> lcp_array(std::span<basic_string_view<TChar, TTraits>> strings)
+	{
+		return lcp_array(std::span<const basic_string_view<TChar, TTraits>>{strings});
+	}
+}
+
+#endif // _PUPPY_STRING_SORT_HPP
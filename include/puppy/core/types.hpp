@@ -11,6 +11,7 @@
 #ifndef _PUPPY_TYPES_HPP
 #define _PUPPY_TYPES_HPP
 
+#include "allocation.hpp"
 #include <cstddef>
 #include <memory>
 
@@ -38,29 +39,104 @@ namespace puppy
 	// --- スマートポインタ型
 
 	/// @brief スコープを持つポインタ
+	/// @details 割り当ての追跡が有効の場合は、解放を記録するデリータを持つ。
+	///          どちらの場合もstd::unique_ptrから変換でき、newで生成したポインタも受け取れる
+	///          (make_scope以外で生成したポインタは解放時にタグのない割り当てとして記録する)
 	template<class TPtr>
+#if PUPPY_ALLOCATION_TRACKING
+	using scope = std::unique_ptr<TPtr, tracking_deleter<TPtr>>;
+#else
 	using scope = std::unique_ptr<TPtr>;
+#endif
+
+	/// @brief スコープを持たないポインタ
+	template<class TPtr>
+	using ref = std::shared_ptr<TPtr>;
+
+#if PUPPY_ALLOCATION_TRACKING
+	namespace detail
+	{
+		/// @brief 割り当てを記録してスコープを持つポインタを生成する
+		template<class TPtr, class... Args>
+		scope<TPtr> make_tracked_scope(const allocation_site* site, Args&&... args)
+		{
+			if constexpr (std::is_unbounded_array_v<TPtr>)
+			{
+				static_assert(sizeof...(Args) == 1, "Array allocation takes only the element count.");
+				using element_type = std::remove_extent_t<TPtr>;
+				const std::size_t count = (static_cast<std::size_t>(args), ...);
+				const std::size_t bytes = sizeof(element_type) * count;
+				element_type* ptr = new element_type[count]();
+				record_allocation(site, bytes);
+				return scope<TPtr>{ptr, tracking_deleter<TPtr>{site, bytes}};
+			}
+			else
+			{
+				TPtr* ptr = new TPtr(std::forward<Args>(args)...);
+				record_allocation(site, sizeof(TPtr));
+				return scope<TPtr>{ptr, tracking_deleter<TPtr>{site, sizeof(TPtr)}};
+			}
+		}
+	}
+#endif
 
 	/// @brief スコープを持つポインタを生成する
+	/// @details 割り当ての追跡が有効の場合は、allocation_scopeのタグとして記録する
 	/// @param args 生成するオブジェクトのコンストラクタ引数
 	template<class TPtr, class... Args>
 	PUPPY_FORCE_INLINE
 	constexpr scope<TPtr> make_scope(Args&&... args)
 	{
+#if PUPPY_ALLOCATION_TRACKING
+		return detail::make_tracked_scope<TPtr>(detail::current_allocation_site(), std::forward<Args>(args)...);
+#else
 		return std::make_unique<TPtr>(std::forward<Args>(args)...);
+#endif
 	}
 
-	/// @brief スコープを持たないポインタ
-	template<class TPtr>
-	using ref = std::shared_ptr<TPtr>;
+	/// @brief タグを付けてスコープを持つポインタを生成する
+	/// @details タグを値で受け取るため、可変長引数のみのオーバーロードより優先される
+	/// @param tag 割り当てのタグ (追跡が無効の場合は無視される)
+	/// @param args 生成するオブジェクトのコンストラクタ引数
+	template<class TPtr, class... Args>
+	PUPPY_FORCE_INLINE
+	constexpr scope<TPtr> make_scope([[maybe_unused]] allocation_tag tag, Args&&... args)
+	{
+#if PUPPY_ALLOCATION_TRACKING
+		return detail::make_tracked_scope<TPtr>(detail::allocation_site_of(tag), std::forward<Args>(args)...);
+#else
+		return std::make_unique<TPtr>(std::forward<Args>(args)...);
+#endif
+	}
 
 	/// @brief スコープを持たないポインタを生成する
+	/// @details 割り当ての追跡が有効の場合は、allocation_scopeのタグとして記録する
 	/// @param args 生成するオブジェクトのコンストラクタ引数
 	template<class TPtr, class... Args>
 	PUPPY_FORCE_INLINE
 	constexpr ref<TPtr> make_ref(Args&&... args)
 	{
+#if PUPPY_ALLOCATION_TRACKING
+		return std::allocate_shared<TPtr>(
+			tracking_allocator<TPtr>{detail::current_allocation_site()}, std::forward<Args>(args)...);
+#else
 		return std::make_shared<TPtr>(std::forward<Args>(args)...);
+#endif
+	}
+
+	/// @brief タグを付けてスコープを持たないポインタを生成する
+	/// @param tag 割り当てのタグ (追跡が無効の場合は無視される)
+	/// @param args 生成するオブジェクトのコンストラクタ引数
+	template<class TPtr, class... Args>
+	PUPPY_FORCE_INLINE
+	constexpr ref<TPtr> make_ref([[maybe_unused]] allocation_tag tag, Args&&... args)
+	{
+#if PUPPY_ALLOCATION_TRACKING
+		return std::allocate_shared<TPtr>(
+			tracking_allocator<TPtr>{detail::allocation_site_of(tag)}, std::forward<Args>(args)...);
+#else
+		return std::make_shared<TPtr>(std::forward<Args>(args)...);
+#endif
 	}
 }
 
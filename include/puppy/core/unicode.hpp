@@ -0,0 +1,284 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#ifndef _PUPPY_UNICODE_HPP
+#define _PUPPY_UNICODE_HPP
+
+#include "common.hpp"
+#include "string_view.hpp"
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <string>
+
+namespace puppy
+{
+	// --- ケースフォールディング
+
+	/// @brief 完全ケースフォールディングで1文字が展開される最大の文字数
+	inline constexpr size_t max_case_fold_length = 3;
+
+	/// @brief 単純ケースフォールディングを行う
+	/// @param c 対象の文字
+	/// @return フォールディングされた文字
+	[[nodiscard]]
+	PUPPY_EXPORT char32_t simple_case_fold(char32_t c) noexcept;
+
+	/// @brief 完全ケースフォールディングを行う
+	/// @param c 対象の文字
+	/// @param out 結果を書き込むバッファ (max_case_fold_length文字以上)
+	/// @return 書き込んだ文字数
+	PUPPY_EXPORT size_t full_case_fold(char32_t c, char32_t* out) noexcept;
+
+	/// @brief 完全ケースフォールディングを行った文字列同士を比較する
+	/// @param lhs 比較する文字列
+	/// @param rhs 比較する文字列
+	/// @return 比較結果 比較対象より大きければ1以上、小さければ1以下、同じであれば0
+	/// @note 正規化は行わない。正準等価な文字列を同一視する場合は事前にNFDへ正規化すること
+	[[nodiscard]]
+	PUPPY_EXPORT int compare_case_insensitive(string_view lhs, string_view rhs) noexcept;
+
+	/// @brief 完全ケースフォールディングを行った文字列同士が等しいかを返す
+	/// @param lhs 比較する文字列
+	/// @param rhs 比較する文字列
+	/// @return 等しいか
+	[[nodiscard]]
+	PUPPY_EXPORT bool equals_case_insensitive(string_view lhs, string_view rhs) noexcept;
+
+	/// @brief 完全ケースフォールディングを行った文字列のハッシュ値を返す
+	/// @param sv 対象の文字列
+	/// @return ハッシュ値 equals_case_insensitiveで等しい文字列は同じ値になる
+	[[nodiscard]]
+	PUPPY_EXPORT size_t hash_case_insensitive(string_view sv) noexcept;
+
+	/// @brief 大文字と小文字を区別しないハッシュ関数オブジェクト
+	struct case_insensitive_hash final
+	{
+		using is_transparent = void;
+
+		[[nodiscard]]
+		size_t operator()(string_view sv) const noexcept
+		{
+			return hash_case_insensitive(sv);
+		}
+	};
+
+	/// @brief 大文字と小文字を区別しない等値比較関数オブジェクト
+	struct case_insensitive_equal final
+	{
+		using is_transparent = void;
+
+		[[nodiscard]]
+		bool operator()(string_view lhs, string_view rhs) const noexcept
+		{
+			return equals_case_insensitive(lhs, rhs);
+		}
+	};
+
+	// --- 正規化
+
+	/// @brief 正規化形式
+	enum class normalization_form : std::uint8_t
+	{
+		nfc, ///< 正準分解の後に正準合成
+		nfd, ///< 正準分解
+	};
+
+	/// @brief 正規化のクイックチェックの結果
+	enum class normalization_check : std::uint8_t
+	{
+		yes,   ///< 正規化済み
+		no,    ///< 正規化されていない
+		maybe, ///< 正規化されているか判定できない
+	};
+
+	/// @brief 文字列が正規化されているかを高速に判定する
+	/// @param sv 対象の文字列
+	/// @param form 正規化形式
+	/// @return 判定結果
+	[[nodiscard]]
+	PUPPY_EXPORT normalization_check quick_check(string_view sv, normalization_form form) noexcept;
+
+	/// @brief 文字列が正規化されているかを返す
+	/// @param sv 対象の文字列
+	/// @param form 正規化形式
+	/// @return 正規化されているか
+	[[nodiscard]]
+	PUPPY_EXPORT bool is_normalized(string_view sv, normalization_form form);
+
+	/// @brief 文字列を正規化する
+	/// @param sv 対象の文字列
+	/// @param form 正規化形式
+	/// @return 正規化された文字列
+	[[nodiscard]]
+	PUPPY_EXPORT std::u32string normalize(string_view sv, normalization_form form);
+
+	// --- セグメンテーション
+
+	/// @brief テキストの分割単位
+	enum class text_segment : std::uint8_t
+	{
+		grapheme, ///< 拡張書記素クラスタ (UAX #29)
+		word,     ///< 単語 (UAX #29)
+	};
+
+	/// @brief 次の書記素クラスタ境界を返す
+	/// @param text 対象の文字列
+	/// @param pos 検索を始める境界の位置
+	/// @return posより後ろにある最初の境界の位置
+	[[nodiscard]]
+	PUPPY_EXPORT size_t next_grapheme_boundary(string_view text, size_t pos) noexcept;
+
+	/// @brief 次の単語境界を返す
+	/// @param text 対象の文字列
+	/// @param pos 検索を始める境界の位置
+	/// @return posより後ろにある最初の境界の位置
+	[[nodiscard]]
+	PUPPY_EXPORT size_t next_word_boundary(string_view text, size_t pos) noexcept;
+
+	/// @brief 文字列を境界ごとに遅延評価で分割するビュー
+	/// @tparam Segment 分割単位
+	template<text_segment Segment>
+	class segment_view final : public std::ranges::view_interface<segment_view<Segment>>
+	{
+	public:
+		/// @brief 分割された文字列を順に返すイテレータ
+		class iterator final
+		{
+		public:
+			// --- 型エイリアス定義
+			using iterator_concept = std::forward_iterator_tag;
+			using value_type       = string_view;
+			using difference_type  = ptrdiff_t;
+
+			// --- コンストラクタ
+
+			constexpr iterator() noexcept = default;
+
+			iterator(string_view text, size_t pos) noexcept
+				: _text{text}, _pos{pos}, _next{next_boundary(text, pos)}
+			{}
+
+			// --- 演算子
+
+			[[nodiscard]]
+			value_type operator*() const noexcept
+			{
+				return _text.substr(_pos, _next - _pos);
+			}
+
+			iterator& operator++() noexcept
+			{
+				_pos = _next;
+				_next = next_boundary(_text, _next);
+				return *this;
+			}
+
+			iterator operator++(int) noexcept
+			{
+				auto temp = *this;
+				++*this;
+				return temp;
+			}
+
+			[[nodiscard]]
+			bool operator==(const iterator& rhs) const noexcept
+			{
+				return _pos == rhs._pos;
+			}
+
+			[[nodiscard]]
+			bool operator==(std::default_sentinel_t) const noexcept
+			{
+				return _pos >= _text.size();
+			}
+
+		private:
+			[[nodiscard]]
+			static size_t next_boundary(string_view text, size_t pos) noexcept
+			{
+				if constexpr (Segment == text_segment::grapheme)
+				{
+					return next_grapheme_boundary(text, pos);
+				}
+				else
+				{
+					return next_word_boundary(text, pos);
+				}
+			}
+
+			// --- メンバ変数定義
+
+			string_view _text;
+			size_t _pos = 0;
+			size_t _next = 0;
+		};
+
+		// --- コンストラクタ
+
+		/// @brief デフォルトコンストラクタ
+		PUPPY_NODISCARD_CTOR
+		constexpr segment_view() noexcept = default;
+
+		/// @brief 分割する文字列を指定して初期化する
+		/// @param text 分割する文字列
+		PUPPY_NODISCARD_CTOR
+		constexpr explicit segment_view(string_view text) noexcept
+			: _text{text}
+		{}
+
+		// --- ゲッターメソッド
+
+		[[nodiscard]]
+		iterator begin() const noexcept
+		{
+			return {_text, 0};
+		}
+
+		[[nodiscard]]
+		std::default_sentinel_t end() const noexcept
+		{
+			return std::default_sentinel;
+		}
+
+	private:
+		// --- メンバ変数定義
+
+		string_view _text;
+	};
+
+	// --- 型エイリアス定義
+	using grapheme_view = segment_view<text_segment::grapheme>;
+	using word_view     = segment_view<text_segment::word>;
+
+	/// @brief 文字列を拡張書記素クラスタごとに分割する
+	/// @param text 分割する文字列
+	/// @return 書記素クラスタを順に返すビュー
+	[[nodiscard]]
+	inline grapheme_view graphemes(string_view text) noexcept
+	{
+		return grapheme_view{text};
+	}
+
+	/// @brief 文字列を単語境界ごとに分割する
+	/// @param text 分割する文字列
+	/// @return 単語境界で区切られた文字列を順に返すビュー
+	/// @note 空白や記号も1つの区間として返される
+	[[nodiscard]]
+	inline word_view words(string_view text) noexcept
+	{
+		return word_view{text};
+	}
+}
+
+template<puppy::text_segment Segment>
+inline constexpr bool std::ranges::enable_borrowed_range<puppy::segment_view<Segment>> = true;
+
+#endif // _PUPPY_UNICODE_HPP
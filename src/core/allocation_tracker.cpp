@@ -0,0 +1,684 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <puppy/core/allocation_tracker.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+
+#if PUPPY_ALLOCATION_TRACKING
+	#include <array>
+	#include <atomic>
+	#include <deque>
+	#include <functional>
+	#include <mutex>
+	#include <new>
+	#include <unordered_map>
+#endif
+
+#if PUPPY_ALLOCATION_TRACKING
+namespace puppy::detail
+{
+	struct allocation_category_record final
+	{
+		allocation_category_record(size_t id, std::string name)
+			: id{id}, name{std::move(name)}
+		{}
+
+		const size_t id;
+		const std::string name;
+	};
+
+	struct allocation_site final
+	{
+		allocation_site(size_t id, const allocation_category_record* category,
+			std::string file, std::string function, std::uint32_t line, std::uint32_t column)
+			: id{id}, category{category}, file{std::move(file)}, function{std::move(function)}, line{line}, column{column}
+		{}
+
+		const size_t id;
+		const allocation_category_record* const category;
+		const std::string file;
+		const std::string function;
+		const std::uint32_t line;
+		const std::uint32_t column;
+	};
+}
+#endif
+
+namespace puppy
+{
+#if PUPPY_ALLOCATION_TRACKING
+	namespace
+	{
+		using detail::allocation_category_record;
+		using detail::allocation_site;
+
+		// --- スレッドごとのカウンタ
+
+		/// @brief 1つのチャンクが持つ割り当て元の数
+		constexpr size_t chunk_size = 256;
+		/// @brief スレッドが持てるチャンクの数
+		constexpr size_t chunk_count = 1024;
+		/// @brief 記録できる割り当て元の数 (超えた分はタグのない割り当てとして記録する)
+		constexpr size_t max_site_count = chunk_size * chunk_count;
+
+		/// @brief 割り当て元ごとのカウンタ
+		/// @details 所有するスレッドだけが書き込み、スナップショットの取得時に他のスレッドから読み込む。
+		///          解放されていないバイト数は全てのスレッドの割り当てと解放の差として集計時に求める
+		struct site_counters final
+		{
+			std::atomic<std::uint64_t> allocations = 0;
+			std::atomic<std::uint64_t> deallocations = 0;
+			std::atomic<std::uint64_t> allocated_bytes = 0;
+			std::atomic<std::uint64_t> freed_bytes = 0;
+		};
+
+		/// @brief 書き込むスレッドが1つのカウンタに加算する (読み込み-変更-書き込みの不可分操作を避ける)
+		PUPPY_FORCE_INLINE
+		void bump(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		/// @brief 1つのスレッドのカウンタ
+		/// @details 割り当て元の識別子で引くチャンクの表で、チャンクは初めて使う時に確保する
+		struct thread_counters final
+		{
+			thread_counters() = default;
+			thread_counters(const thread_counters&) = delete;
+			thread_counters& operator=(const thread_counters&) = delete;
+
+			~thread_counters()
+			{
+				for (auto& chunk : chunks)
+				{
+					delete[] chunk.load(std::memory_order_relaxed);
+				}
+			}
+
+			/// @brief カウンタを返す (書き込むスレッドのみ)
+			/// @return カウンタ、チャンクを確保できなければnullptr
+			site_counters* get(size_t id) noexcept
+			{
+				auto& slot = chunks[id / chunk_size];
+				site_counters* chunk = slot.load(std::memory_order_relaxed);
+				if (chunk == nullptr) PUPPY_UNLIKELY
+				{
+					chunk = new(std::nothrow) site_counters[chunk_size]{};
+					if (chunk == nullptr)
+					{
+						return nullptr;
+					}
+					slot.store(chunk, std::memory_order_release);
+				}
+				return chunk + id % chunk_size;
+			}
+
+			/// @brief カウンタを返す (読み込むスレッド)
+			/// @return カウンタ、まだ書き込まれていなければnullptr
+			const site_counters* find(size_t id) const noexcept
+			{
+				const site_counters* chunk = chunks[id / chunk_size].load(std::memory_order_acquire);
+				return chunk == nullptr ? nullptr : chunk + id % chunk_size;
+			}
+
+			std::array<std::atomic<site_counters*>, chunk_count> chunks{};
+		};
+
+		// --- 割り当て元の登録
+
+		struct registry final
+		{
+			registry()
+			{
+				untagged = &site("general", "", "", 0, 0);
+			}
+
+			/// @brief 割り当て元を返す (存在しなければ登録する)
+			/// @details mutexをロックした状態で呼び出す
+			allocation_site& site(std::string_view category_name, std::string_view file, std::string_view function,
+				std::uint32_t line, std::uint32_t column)
+			{
+				std::string key;
+				key.reserve(category_name.size() + file.size() + function.size() + 24);
+				key.append(category_name).append(1, '\0')
+					.append(file).append(1, '\0')
+					.append(function).append(1, '\0')
+					.append(std::to_string(line)).append(1, ':').append(std::to_string(column));
+				if (const auto found = site_index.find(key); found != site_index.end())
+				{
+					return *found->second;
+				}
+				if (sites.size() >= max_site_count)
+				{
+					return *untagged;
+				}
+
+				// 確保に失敗した場合は登録前の状態に戻して例外を送出する
+				allocation_category_record* category_record;
+				if (const auto found = category_index.find(std::string{category_name}); found != category_index.end())
+				{
+					category_record = found->second;
+				}
+				else
+				{
+					category_record = &categories.emplace_back(categories.size(), std::string{category_name});
+					try
+					{
+						category_index.emplace(category_record->name, category_record);
+					}
+					catch (...)
+					{
+						categories.pop_back();
+						throw;
+					}
+				}
+
+				auto& result = sites.emplace_back(sites.size(), category_record, std::string{file}, std::string{function}, line, column);
+				try
+				{
+					site_index.emplace(std::move(key), &result);
+				}
+				catch (...)
+				{
+					sites.pop_back();
+					throw;
+				}
+				return result;
+			}
+
+			std::mutex mutex;
+			std::deque<allocation_site> sites;
+			std::unordered_map<std::string, allocation_site*> site_index;
+			std::deque<allocation_category_record> categories;
+			std::unordered_map<std::string, allocation_category_record*> category_index;
+			/// @brief 実行中のスレッドのカウンタ
+			std::vector<thread_counters*> threads;
+			/// @brief 終了したスレッドのカウンタの合計
+			thread_counters retired;
+			/// @brief 集計時に観測した解放されていないバイト数の最大値
+			std::vector<std::int64_t> site_peaks;
+			std::vector<std::int64_t> category_peaks;
+			std::int64_t total_peak = 0;
+			allocation_snapshot::clock::time_point start = allocation_snapshot::clock::now();
+			allocation_site* untagged = nullptr;
+		};
+
+		/// @brief 登録先を返す
+		/// @details 静的オブジェクトの破棄中の解放も記録できるように破棄しない
+		registry& get_registry()
+		{
+			static registry* const instance = new registry;
+			return *instance;
+		}
+
+		// 割り当ての記録中に初めて確保して失敗しないように、プログラムの開始時に登録先を生成する
+		[[maybe_unused]] registry& g_registry = get_registry();
+
+		// --- スレッドの状態
+
+		/// @brief タグからスレッドごとに割り当て元を引くためのキー
+		/// @details source_locationの文字列は静的な寿命を持つため、ポインタで比較する
+		struct site_cache_key final
+		{
+			const char* category;
+			const char* file;
+			const char* function;
+			std::uint32_t line;
+			std::uint32_t column;
+
+			bool operator==(const site_cache_key&) const noexcept = default;
+		};
+
+		struct site_cache_key_hash final
+		{
+			size_t operator()(const site_cache_key& key) const noexcept
+			{
+				size_t hash = std::hash<const void*>{}(key.category);
+				hash = hash * 31 + std::hash<const void*>{}(key.file);
+				hash = hash * 31 + std::hash<const void*>{}(key.function);
+				return hash * 31 + (static_cast<size_t>(key.line) << 16 ^ key.column);
+			}
+		};
+
+		using site_cache = std::unordered_map<site_cache_key, const allocation_site*, site_cache_key_hash>;
+
+		/// @brief スレッドの終了時にカウンタを合計に移す
+		struct thread_exit final
+		{
+			~thread_exit();
+		};
+
+		// 割り当てのたびに初期化の確認が入らないように、状態は自明なthread_local変数に置く
+		thread_local thread_counters* t_counters = nullptr;
+		thread_local site_cache* t_cache = nullptr;
+		thread_local const allocation_site* t_current = nullptr;
+		thread_local bool t_exited = false;
+		thread_local thread_exit t_exit;
+
+		/// @brief スレッドの終了時の処理を登録する
+		/// @return スレッドの状態を使えるか (終了処理の後はfalse)
+		bool attach_thread() noexcept
+		{
+			if (t_exited)
+			{
+				return false;
+			}
+			[[maybe_unused]] thread_exit* exit = &t_exit;
+			return true;
+		}
+
+		thread_exit::~thread_exit()
+		{
+			t_exited = true;
+			auto& reg = get_registry();
+			std::lock_guard lock{reg.mutex};
+			if (t_counters != nullptr)
+			{
+				for (size_t id = 0; id < reg.sites.size(); ++id)
+				{
+					if (const auto* counters = t_counters->find(id))
+					{
+						auto* retired = reg.retired.get(id);
+						if (retired == nullptr)
+						{
+							continue;
+						}
+						bump(retired->allocations, counters->allocations.load(std::memory_order_relaxed));
+						bump(retired->deallocations, counters->deallocations.load(std::memory_order_relaxed));
+						bump(retired->allocated_bytes, counters->allocated_bytes.load(std::memory_order_relaxed));
+						bump(retired->freed_bytes, counters->freed_bytes.load(std::memory_order_relaxed));
+					}
+				}
+				std::erase(reg.threads, t_counters);
+				delete t_counters;
+				t_counters = nullptr;
+			}
+			delete t_cache;
+			t_cache = nullptr;
+		}
+
+		/// @brief 回数とバイト数を加算する
+		void accumulate(allocation_stats& to, const allocation_stats& from) noexcept
+		{
+			to.allocations += from.allocations;
+			to.deallocations += from.deallocations;
+			to.allocated_bytes += from.allocated_bytes;
+			to.freed_bytes += from.freed_bytes;
+		}
+
+		/// @brief スレッドのカウンタを登録する
+		/// @return 登録したカウンタ、スレッドの終了処理の後や確保に失敗した場合はnullptr
+		thread_counters* register_thread() noexcept
+		{
+			if (!attach_thread())
+			{
+				return nullptr;
+			}
+			auto* counters = new(std::nothrow) thread_counters;
+			if (counters == nullptr)
+			{
+				return nullptr;
+			}
+			try
+			{
+				auto& reg = get_registry();
+				std::lock_guard lock{reg.mutex};
+				reg.threads.push_back(counters);
+			}
+			catch (...)
+			{
+				delete counters;
+				return nullptr;
+			}
+			t_counters = counters;
+			return counters;
+		}
+
+		/// @brief 割り当て元のカウンタを更新する
+		template<class Update>
+		PUPPY_FORCE_INLINE
+		void update_counters(const allocation_site& site, Update update) noexcept
+		{
+			thread_counters* counters = t_counters;
+			if (counters == nullptr) PUPPY_UNLIKELY
+			{
+				counters = register_thread();
+			}
+			if (counters != nullptr) PUPPY_LIKELY
+			{
+				if (auto* counter = counters->get(site.id)) PUPPY_LIKELY
+				{
+					update(*counter);
+					return;
+				}
+			}
+
+			// スレッドの終了処理の後や確保に失敗した場合は、合計に直接記録する
+			auto& reg = get_registry();
+			std::lock_guard lock{reg.mutex};
+			if (auto* counters = reg.retired.get(site.id))
+			{
+				update(*counters);
+			}
+		}
+
+		/// @brief 集計した統計情報
+		struct collected_stats final
+		{
+			std::vector<allocation_stats> sites;
+			std::vector<allocation_stats> categories;
+			allocation_stats total;
+		};
+
+		/// @brief 全てのスレッドのカウンタを集計し、ピークを更新する
+		/// @details mutexをロックした状態で呼び出す
+		collected_stats collect(registry& reg)
+		{
+			collected_stats result{
+				std::vector<allocation_stats>(reg.sites.size()),
+				std::vector<allocation_stats>(reg.categories.size()),
+				{}};
+			reg.site_peaks.resize(reg.sites.size());
+			reg.category_peaks.resize(reg.categories.size());
+
+			const auto update_peak = [](allocation_stats& stats, std::int64_t& peak)
+			{
+				stats.live_bytes = static_cast<std::int64_t>(stats.allocated_bytes - stats.freed_bytes);
+				peak = std::max(peak, stats.live_bytes);
+				stats.sampled_peak_bytes = peak;
+			};
+
+			for (const auto& site : reg.sites)
+			{
+				auto& stats = result.sites[site.id];
+				const auto add = [&](const thread_counters& counters)
+				{
+					if (const auto* counter = counters.find(site.id))
+					{
+						stats.allocations += counter->allocations.load(std::memory_order_relaxed);
+						stats.deallocations += counter->deallocations.load(std::memory_order_relaxed);
+						stats.allocated_bytes += counter->allocated_bytes.load(std::memory_order_relaxed);
+						stats.freed_bytes += counter->freed_bytes.load(std::memory_order_relaxed);
+					}
+				};
+				add(reg.retired);
+				for (const auto* counters : reg.threads)
+				{
+					add(*counters);
+				}
+				update_peak(stats, reg.site_peaks[site.id]);
+				accumulate(result.categories[site.category->id], stats);
+				accumulate(result.total, stats);
+			}
+
+			for (const auto& category : reg.categories)
+			{
+				update_peak(result.categories[category.id], reg.category_peaks[category.id]);
+			}
+			update_peak(result.total, reg.total_peak);
+			return result;
+		}
+	}
+
+	namespace detail
+	{
+		const allocation_site* find_allocation_site(const allocation_tag& tag) noexcept
+		{
+			const site_cache_key key{tag.category.name, tag.location.file_name(), tag.location.function_name(),
+				tag.location.line(), tag.location.column()};
+			const bool attached = attach_thread();
+			if (attached && t_cache != nullptr)
+			{
+				if (const auto found = t_cache->find(key); found != t_cache->end())
+				{
+					return found->second;
+				}
+			}
+
+			auto& reg = get_registry();
+			const allocation_site* site;
+			try
+			{
+				std::lock_guard lock{reg.mutex};
+				site = &reg.site(key.category, key.file, key.function, key.line, key.column);
+			}
+			catch (...)
+			{
+				// 割り当て元を登録できない場合はタグのない割り当てとして記録する
+				return reg.untagged;
+			}
+
+			if (attached)
+			{
+				try
+				{
+					if (t_cache == nullptr)
+					{
+						t_cache = new site_cache;
+					}
+					t_cache->emplace(key, site);
+				}
+				catch (...)
+				{
+					// キャッシュできなくても次回に引き直すだけで記録には影響しない
+				}
+			}
+			return site;
+		}
+
+		const allocation_site* current_allocation_site() noexcept
+		{
+			return t_current != nullptr ? t_current : get_registry().untagged;
+		}
+
+		const allocation_site* exchange_current_allocation_site(const allocation_site* site) noexcept
+		{
+			return std::exchange(t_current, site);
+		}
+
+		void record_allocation(const allocation_site* site, std::size_t bytes) noexcept
+		{
+			update_counters(*site, [bytes](site_counters& counters)
+			{
+				bump(counters.allocations, 1);
+				bump(counters.allocated_bytes, bytes);
+			});
+		}
+
+		void record_deallocation(const allocation_site* site, std::size_t bytes) noexcept
+		{
+			update_counters(*site, [bytes](site_counters& counters)
+			{
+				bump(counters.deallocations, 1);
+				bump(counters.freed_bytes, bytes);
+			});
+		}
+	}
+#endif
+
+	namespace
+	{
+		/// @brief 以前の記録との差を取る (差分はピークを持たない)
+		void subtract(allocation_stats& to, const allocation_stats& from) noexcept
+		{
+			to.allocations -= from.allocations;
+			to.deallocations -= from.deallocations;
+			to.allocated_bytes -= from.allocated_bytes;
+			to.freed_bytes -= from.freed_bytes;
+			to.live_bytes -= from.live_bytes;
+			to.sampled_peak_bytes = 0;
+		}
+
+		/// @brief 以前の記録との差を取り、変化のない記録を取り除く
+		std::vector<allocation_record> diff_records(const std::vector<allocation_record>& later, const std::vector<allocation_record>& earlier)
+		{
+			std::vector<allocation_record> result;
+			for (const auto& record : later)
+			{
+				auto& current = result.emplace_back(record);
+				current.stats.sampled_peak_bytes = 0;
+				const auto found = std::lower_bound(earlier.begin(), earlier.end(), record.id,
+					[](const allocation_record& lhs, size_t id) { return lhs.id < id; });
+				if (found != earlier.end() && found->id == record.id)
+				{
+					subtract(current.stats, found->stats);
+				}
+				if (current.stats.allocations == 0 && current.stats.deallocations == 0)
+				{
+					result.pop_back();
+				}
+			}
+			return result;
+		}
+	}
+
+	allocation_snapshot allocation_snapshot::capture()
+	{
+		allocation_snapshot snapshot;
+		snapshot._time = clock::now();
+
+#if PUPPY_ALLOCATION_TRACKING
+		auto& reg = get_registry();
+		std::lock_guard lock{reg.mutex};
+		snapshot._duration = snapshot._time - reg.start;
+
+		const auto collected = collect(reg);
+		for (const auto& site : reg.sites)
+		{
+			const auto& stats = collected.sites[site.id];
+			if (stats.allocations != 0)
+			{
+				snapshot._sites.push_back(allocation_record{
+					site.id, site.category->name, site.file, site.function, site.line, site.column, stats});
+			}
+		}
+		for (const auto& category : reg.categories)
+		{
+			const auto& stats = collected.categories[category.id];
+			if (stats.allocations != 0)
+			{
+				snapshot._categories.push_back(allocation_record{category.id, category.name, {}, {}, 0, 0, stats});
+			}
+		}
+		snapshot._total = collected.total;
+#endif
+
+		return snapshot;
+	}
+
+	void allocation_snapshot::sample_peaks()
+	{
+#if PUPPY_ALLOCATION_TRACKING
+		auto& reg = get_registry();
+		std::lock_guard lock{reg.mutex};
+		(void)collect(reg);
+#endif
+	}
+
+	allocation_snapshot allocation_snapshot::diff(const allocation_snapshot& earlier) const
+	{
+		allocation_snapshot result;
+		result._time = _time;
+		result._duration = _time - earlier._time;
+		result._sites = diff_records(_sites, earlier._sites);
+		result._categories = diff_records(_categories, earlier._categories);
+		result._total = _total;
+		subtract(result._total, earlier._total);
+		result._difference = true;
+		return result;
+	}
+
+	void allocation_snapshot::dump(std::ostream& stream) const
+	{
+		const auto flags = stream.flags();
+		const auto precision = stream.precision();
+		const auto seconds = std::chrono::duration<double>{_duration}.count();
+		stream << std::fixed << std::setprecision(3) << "allocations over " << seconds << "s: "
+			<< _total.allocations << " allocations, " << _total.live_bytes << " live bytes\n";
+		stream << std::setprecision(1);
+
+		const auto header = [&](const char* title)
+		{
+			stream << std::left << std::setw(24) << title << std::right
+				<< std::setw(14) << (_difference ? "live delta" : "live") << std::setw(14) << "sampled peak"
+				<< std::setw(12) << "allocs" << std::setw(12) << "frees" << std::setw(14) << "allocs/s" << '\n';
+		};
+		const auto row = [&](const allocation_record& record)
+		{
+			stream << std::left << std::setw(24) << record.category << std::right
+				<< std::setw(14) << record.stats.live_bytes;
+			// 差分はピークを持たない
+			if (_difference)
+			{
+				stream << std::setw(14) << '-';
+			}
+			else
+			{
+				stream << std::setw(14) << record.stats.sampled_peak_bytes;
+			}
+			stream << std::setw(12) << record.stats.allocations
+				<< std::setw(12) << record.stats.deallocations
+				<< std::setw(14) << allocation_rate(record);
+		};
+		const auto sorted = [](std::vector<allocation_record> records)
+		{
+			std::stable_sort(records.begin(), records.end(), [](const allocation_record& lhs, const allocation_record& rhs)
+			{
+				return lhs.stats.live_bytes > rhs.stats.live_bytes;
+			});
+			return records;
+		};
+
+		header("category");
+		for (const auto& record : sorted(_categories))
+		{
+			row(record);
+			stream << '\n';
+		}
+
+		header("site");
+		for (const auto& record : sorted(_sites))
+		{
+			row(record);
+			if (record.file.empty())
+			{
+				stream << "  (untagged)\n";
+			}
+			else
+			{
+				stream << "  " << record.file << ':' << record.line << ' ' << record.function << '\n';
+			}
+		}
+
+		stream.flags(flags);
+		stream.precision(precision);
+	}
+
+	const allocation_record* allocation_snapshot::category(std::string_view name) const noexcept
+	{
+		const auto found = std::find_if(_categories.begin(), _categories.end(),
+			[name](const allocation_record& record) { return record.category == name; });
+		return found == _categories.end() ? nullptr : &*found;
+	}
+
+	allocation_stats allocation_snapshot::total() const noexcept
+	{
+		return _total;
+	}
+
+	double allocation_snapshot::allocation_rate(const allocation_record& record) const noexcept
+	{
+		const auto seconds = std::chrono::duration<double>{_duration}.count();
+		return seconds <= 0.0 ? 0.0 : static_cast<double>(record.stats.allocations) / seconds;
+	}
+}
@@ -0,0 +1,746 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <puppy/core/asset_cache.hpp>
+#include <puppy/core/contracts.hpp>
+#include <algorithm>
+#include <bit>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if PUPPY_PLATFORM_LINUX
+	#include <cerrno>
+	#include <poll.h>
+	#include <sys/eventfd.h>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+namespace puppy
+{
+	namespace
+	{
+		using clock_type = std::chrono::steady_clock;
+
+		/// @brief キャッシュのエントリの割り当てのカテゴリ
+		constexpr allocation_category asset_cache_category{"asset_cache"};
+
+		/// @brief ローダーを実行中のスレッドであるか
+		/// @details ローダーの中から別のアセットを同期的に要求した場合に、ワーカーの枯渇による
+		///          デッドロックを避けるためその場で読み込む
+		thread_local bool t_loader_thread = false;
+
+		// --- エントリ
+
+		struct asset_entry final
+		{
+			asset_entry(std::type_index type, std::u32string path, std::filesystem::path file)
+				: type{type}, path{std::move(path)}, file{std::move(file)}
+			{}
+
+			std::type_index type;
+			std::u32string path;
+			/// @brief 変更の監視に使う正規化済みの絶対パス
+			std::filesystem::path file;
+
+			ref<void> value;
+			size_t bytes = 0;
+			bool resident = false;
+			std::list<asset_entry*>::iterator lru;
+
+			// 読み込み中のみ有効
+			asset_loader<void> loader;
+			std::promise<ref<void>> promise;
+			std::shared_future<ref<void>> pending;
+		};
+
+		struct entry_key final
+		{
+			std::type_index type;
+			std::u32string path;
+		};
+
+		struct entry_key_view final
+		{
+			std::type_index type;
+			std::u32string_view path;
+		};
+
+		struct entry_key_hash final
+		{
+			using is_transparent = void;
+
+			size_t operator()(const entry_key_view& key) const noexcept
+			{
+				return std::hash<std::u32string_view>{}(key.path) ^ (key.type.hash_code() * 0x9E3779B97F4A7C15ull);
+			}
+
+			size_t operator()(const entry_key& key) const noexcept
+			{
+				return (*this)(entry_key_view{key.type, key.path});
+			}
+		};
+
+		struct entry_key_equal final
+		{
+			using is_transparent = void;
+
+			template<class TLhs, class TRhs>
+			bool operator()(const TLhs& lhs, const TRhs& rhs) const noexcept
+			{
+				return lhs.type == rhs.type && std::u32string_view{lhs.path} == std::u32string_view{rhs.path};
+			}
+		};
+
+		using entry_map = std::unordered_map<entry_key, ref<asset_entry>, entry_key_hash, entry_key_equal>;
+
+		struct type_state final
+		{
+			asset_loader<void> loader;
+			asset_cache_stats stats;
+		};
+
+		[[nodiscard]]
+		std::filesystem::path normalize_path(std::u32string_view path)
+		{
+			const std::filesystem::path file{std::u32string{path}};
+			std::error_code error;
+			const auto absolute = std::filesystem::absolute(file, error);
+			return error ? file.lexically_normal() : absolute.lexically_normal();
+		}
+
+		void record_latency(asset_cache_stats& stats, clock_type::duration elapsed) noexcept
+		{
+			const auto micro = static_cast<std::uint64_t>(
+				std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), 0));
+			const auto bucket = std::min<size_t>(
+				micro == 0 ? 0 : static_cast<size_t>(std::bit_width(micro)) - 1,
+				asset_cache_stats::latency_bucket_count - 1);
+			++stats.load_latency[bucket];
+		}
+
+#if PUPPY_PLATFORM_LINUX
+		/// @brief inotifyでディレクトリを監視し、ファイルの変更を通知する
+		class file_watcher final
+		{
+		public:
+			/// @brief 変更されたファイルを受け取る関数 (イベントを取りこぼした場合は空のパス)
+			using callback_type = std::function<void(const std::filesystem::path&)>;
+
+			explicit file_watcher(callback_type callback)
+				: _callback{std::move(callback)}
+				, _inotify{::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}
+				, _wake{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+			{
+				if (_inotify >= 0 && _wake >= 0)
+				{
+					_thread = std::jthread{[this] { run(); }};
+				}
+			}
+
+			~file_watcher()
+			{
+				if (_thread.joinable())
+				{
+					const std::uint64_t value = 1;
+					[[maybe_unused]] const auto written = ::write(_wake, &value, sizeof(value));
+					_thread.join();
+				}
+				if (_inotify >= 0)
+				{
+					::close(_inotify);
+				}
+				if (_wake >= 0)
+				{
+					::close(_wake);
+				}
+			}
+
+			PUPPY_NOT_COPYABLE(file_watcher);
+			PUPPY_NOT_MOVEABLE(file_watcher);
+
+			/// @brief ファイルを含むディレクトリを監視する
+			/// @details 保存時に一時ファイルを置き換えるエディタにも対応するため、ファイルではなくディレクトリを監視する
+			void watch(const std::filesystem::path& file)
+			{
+				if (!_thread.joinable())
+				{
+					return;
+				}
+
+				auto directory = file.parent_path();
+				std::lock_guard lock{_mutex};
+				if (_watched.contains(directory.native()))
+				{
+					return;
+				}
+				const int descriptor = ::inotify_add_watch(_inotify, directory.c_str(),
+					IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+				if (descriptor < 0)
+				{
+					return;
+				}
+				_watched.emplace(directory.native(), descriptor);
+				_directories.insert_or_assign(descriptor, std::move(directory));
+			}
+
+		private:
+			void run()
+			{
+				alignas(inotify_event) char buffer[4096];
+				pollfd fds[2]{{_inotify, POLLIN, 0}, {_wake, POLLIN, 0}};
+				while (true)
+				{
+					if (::poll(fds, 2, -1) < 0)
+					{
+						if (errno == EINTR)
+						{
+							continue;
+						}
+						return;
+					}
+					if (fds[1].revents != 0)
+					{
+						return;
+					}
+
+					ssize_t size = 0;
+					while ((size = ::read(_inotify, buffer, sizeof(buffer))) > 0)
+					{
+						for (ssize_t offset = 0; offset < size;)
+						{
+							const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+							offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+							handle(*event);
+						}
+					}
+				}
+			}
+
+			void handle(const inotify_event& event)
+			{
+				if (event.mask & IN_Q_OVERFLOW)
+				{
+					// キューが溢れてどのファイルが変更されたか分からない
+					_callback({});
+					return;
+				}
+
+				std::filesystem::path file;
+				{
+					std::lock_guard lock{_mutex};
+					const auto found = _directories.find(event.wd);
+					if (found == _directories.end())
+					{
+						return;
+					}
+					if (event.mask & IN_IGNORED)
+					{
+						// ディレクトリが削除された
+						_watched.erase(found->second.native());
+						_directories.erase(found);
+						return;
+					}
+					if (event.len == 0)
+					{
+						return;
+					}
+					file = found->second / event.name;
+				}
+				_callback(file);
+			}
+
+			// --- メンバ変数定義
+			callback_type _callback;
+			int _inotify;
+			int _wake;
+			std::mutex _mutex;
+			std::unordered_map<std::string, int> _watched;
+			std::unordered_map<int, std::filesystem::path> _directories;
+			std::jthread _thread;
+		};
+#endif
+	}
+
+	struct asset_cache::impl final
+	{
+		explicit impl(const asset_cache_options& options)
+			: budget{options.budget}
+		{
+			const size_t thread_count = options.thread_count != 0
+				? options.thread_count
+				: std::max<size_t>(std::thread::hardware_concurrency(), 1);
+			for (size_t i = 0; i < thread_count; ++i)
+			{
+				workers.emplace_back([this] { work(); });
+			}
+
+#if PUPPY_PLATFORM_LINUX
+			if (options.hot_reload)
+			{
+				watcher = make_scope<file_watcher>(allocation_tag{asset_cache_category}, [this](const std::filesystem::path& file)
+				{
+					on_file_changed(file);
+				});
+			}
+#endif
+		}
+
+		~impl()
+		{
+			{
+				std::lock_guard lock{queue_mutex};
+				stopping = true;
+			}
+			queue_condition.notify_all();
+			// ワーカーは監視を追加しうるため、監視より先に停止する
+			workers.clear();
+		}
+
+		PUPPY_NOT_COPYABLE(impl);
+		PUPPY_NOT_MOVEABLE(impl);
+
+		// --- 要求
+
+		/// @brief 読み込み済みであれば値を返し、そうでなければ読み込みの完了を待つfutureを設定する
+		/// @param entry 読み込み中のエントリが設定される
+		/// @param started 新しく読み込みを開始した場合にtrueが設定される
+		ref<void> request(
+			std::type_index type,
+			string_view path,
+			std::shared_future<ref<void>>& future,
+			ref<asset_entry>& entry,
+			bool& started)
+		{
+			const std::u32string_view key{path.data(), path.size()};
+			std::filesystem::path file;
+			bool normalized = false;
+			std::unique_lock lock{mutex};
+			while (true)
+			{
+				const auto state = types.find(type);
+				PUPPY_EXPECTS(state != types.end());
+				auto& stats = state->second.stats;
+
+				if (const auto found = entries.find(entry_key_view{type, key}); found != entries.end())
+				{
+					auto& current = *found->second;
+					if (current.resident)
+					{
+						++stats.hits;
+						lru.splice(lru.begin(), lru, current.lru);
+						return current.value;
+					}
+					++stats.merged;
+					future = current.pending;
+					entry = found->second;
+					return nullptr;
+				}
+
+				// パスの正規化はファイルシステムに問い合わせるため、ロックを手放して行い、その間の変更を確認し直す
+				if (!normalized)
+				{
+					lock.unlock();
+					file = normalize_path(key);
+					normalized = true;
+					lock.lock();
+					continue;
+				}
+
+				++stats.misses;
+				entry = make_ref<asset_entry>(PUPPY_ALLOCATION_TAG(asset_cache_category), type, std::u32string{key}, std::move(file));
+				entry->loader = state->second.loader;
+				entry->pending = entry->promise.get_future().share();
+				future = entry->pending;
+				entries.emplace(entry_key{type, entry->path}, entry);
+				files.emplace(entry->file.native(), entry.get());
+				started = true;
+				return nullptr;
+			}
+		}
+
+		void start(ref<asset_entry> entry, bool inline_load)
+		{
+#if PUPPY_PLATFORM_LINUX
+			if (watcher)
+			{
+				watcher->watch(entry->file);
+			}
+#endif
+			if (inline_load)
+			{
+				load(entry);
+				return;
+			}
+			{
+				std::lock_guard lock{queue_mutex};
+				queue.push_back(std::move(entry));
+			}
+			queue_condition.notify_one();
+		}
+
+		/// @brief 読み込みの待ち行列からエントリを取り出す
+		/// @return 待ち行列にあった場合はtrue (まだ読み込みが始まっていない)
+		bool dequeue(const ref<asset_entry>& entry)
+		{
+			std::lock_guard lock{queue_mutex};
+			const auto found = std::find(queue.begin(), queue.end(), entry);
+			if (found == queue.end())
+			{
+				return false;
+			}
+			queue.erase(found);
+			return true;
+		}
+
+		// --- 読み込み
+
+		void work()
+		{
+			t_loader_thread = true;
+			while (true)
+			{
+				ref<asset_entry> entry;
+				{
+					std::unique_lock lock{queue_mutex};
+					queue_condition.wait(lock, [this] { return stopping || !queue.empty(); });
+					if (queue.empty())
+					{
+						return;
+					}
+					entry = std::move(queue.front());
+					queue.pop_front();
+				}
+				load(entry);
+			}
+		}
+
+		void load(const ref<asset_entry>& entry)
+		{
+			const auto start = clock_type::now();
+			asset_data<void> data;
+			try
+			{
+				data = entry->loader(entry->file);
+			}
+			catch (...)
+			{
+				// 例外を送出したローダーは失敗として扱い、待っている要求元とワーカーを巻き込まない
+				data = {};
+			}
+			const auto elapsed = clock_type::now() - start;
+
+			std::lock_guard lock{mutex};
+			auto& stats = types.at(entry->type).stats;
+			record_latency(stats, elapsed);
+			auto promise = std::move(entry->promise);
+			entry->pending = {};
+			entry->loader = nullptr;
+			if (!data.value)
+			{
+				++stats.failures;
+			}
+
+			// 読み込み中に無効化されたエントリは要求元に返すだけで保持しない
+			const auto found = entries.find(entry_key_view{entry->type, entry->path});
+			if (found != entries.end() && found->second == entry)
+			{
+				if (data.value)
+				{
+					entry->value = data.value;
+					entry->bytes = data.bytes;
+					entry->resident = true;
+					lru.push_front(entry.get());
+					entry->lru = lru.begin();
+					stats.resident_bytes += data.bytes;
+					++stats.resident_count;
+					resident_bytes += data.bytes;
+					evict(&entry->type, entry.get());
+				}
+				else
+				{
+					erase(found);
+				}
+			}
+
+			// 値を保持するpromiseをロック中に破棄し、同期的な要求元がロックを経由して戻った時点で
+			// 読み込みによる一時的な参照が残らないようにする
+			promise.set_value(std::move(data.value));
+		}
+
+		// --- 追い出し
+
+		/// @brief 保持しているエントリを手放し、LRUリストで次の位置を返す
+		std::list<asset_entry*>::iterator release(asset_entry& entry) noexcept
+		{
+			auto& stats = types.at(entry.type).stats;
+			stats.resident_bytes -= entry.bytes;
+			--stats.resident_count;
+			resident_bytes -= entry.bytes;
+			entry.resident = false;
+			entry.value.reset();
+			return lru.erase(entry.lru);
+		}
+
+		/// @brief エントリを表から取り除く
+		void erase(entry_map::iterator it) noexcept
+		{
+			const auto [first, last] = files.equal_range(it->second->file.native());
+			const auto found = std::find_if(first, last, [&](const auto& file) { return file.second == it->second.get(); });
+			if (found != last)
+			{
+				files.erase(found);
+			}
+			entries.erase(it);
+		}
+
+		/// @brief エントリをキャッシュから取り除く
+		void drop(entry_map::iterator it) noexcept
+		{
+			if (it->second->resident)
+			{
+				release(*it->second);
+			}
+			erase(it);
+		}
+
+		/// @brief 予算に収まるまで、最も長く使われていないエントリから追い出す
+		/// @param type 予算を確認する型 (nullptrの場合は全体の予算のみ)
+		/// @param keep 追い出さないエントリ
+		void evict(const std::type_index* type, const asset_entry* keep)
+		{
+			const asset_cache_stats* state = type != nullptr ? &types.at(*type).stats : nullptr;
+			const auto over_type = [&] { return state != nullptr && state->resident_bytes > state->budget; };
+			const auto over_global = [&] { return resident_bytes > budget; };
+
+			for (auto it = lru.end(); it != lru.begin() && (over_global() || over_type());)
+			{
+				--it;
+				asset_entry* entry = *it;
+				// キャッシュの外で参照されているエントリは追い出してもメモリが解放されない
+				if (entry == keep || entry->value.use_count() > 1)
+				{
+					continue;
+				}
+				if (!over_global() && entry->type != *type)
+				{
+					continue;
+				}
+
+				++types.at(entry->type).stats.evictions;
+				const auto found = entries.find(entry_key_view{entry->type, entry->path});
+				it = release(*entry);
+				erase(found);
+			}
+		}
+
+		// --- 無効化
+
+		/// @brief ファイルを読み込んだエントリを無効化する
+		/// @param file 変更されたファイル (空の場合は全てのエントリ)
+		void on_file_changed(const std::filesystem::path& file)
+		{
+			std::lock_guard lock{mutex};
+			if (file.empty())
+			{
+				while (!entries.empty())
+				{
+					++types.at(entries.begin()->second->type).stats.reloads;
+					drop(entries.begin());
+				}
+				return;
+			}
+
+			const auto [first, last] = files.equal_range(file.native());
+			std::vector<asset_entry*> changed;
+			for (auto it = first; it != last; ++it)
+			{
+				changed.push_back(it->second);
+			}
+			for (const auto* entry : changed)
+			{
+				++types.at(entry->type).stats.reloads;
+				drop(entries.find(entry_key_view{entry->type, entry->path}));
+			}
+		}
+
+		// --- メンバ変数定義
+
+		mutable std::mutex mutex;
+		std::unordered_map<std::type_index, type_state> types;
+		entry_map entries;
+		/// @brief 正規化済みのパスからエントリを引く索引
+		std::unordered_multimap<std::filesystem::path::string_type, asset_entry*> files;
+		/// @brief 先頭ほど最近使われたエントリ
+		std::list<asset_entry*> lru;
+		size_t budget;
+		size_t resident_bytes = 0;
+
+		std::mutex queue_mutex;
+		std::condition_variable queue_condition;
+		std::deque<ref<asset_entry>> queue;
+		bool stopping = false;
+		std::vector<std::jthread> workers;
+
+#if PUPPY_PLATFORM_LINUX
+		scope<file_watcher> watcher;
+#endif
+	};
+
+	asset_cache::asset_cache(const asset_cache_options& options)
+		: _impl{make_scope<impl>(allocation_tag{asset_cache_category}, options)}
+	{}
+
+	asset_cache::~asset_cache() = default;
+
+	void asset_cache::register_loader(std::type_index type, asset_loader<void> loader, size_t budget)
+	{
+		PUPPY_EXPECTS(static_cast<bool>(loader));
+		std::lock_guard lock{_impl->mutex};
+		auto& state = _impl->types[type];
+		state.loader = std::move(loader);
+		state.stats.budget = budget;
+		_impl->evict(&type, nullptr);
+	}
+
+	ref<void> asset_cache::acquire(std::type_index type, string_view path)
+	{
+		std::shared_future<ref<void>> future;
+		ref<asset_entry> entry;
+		bool started = false;
+		if (auto value = _impl->request(type, path, future, entry, started))
+		{
+			return value;
+		}
+		if (started)
+		{
+			_impl->start(std::move(entry), t_loader_thread);
+		}
+		else if (t_loader_thread && _impl->dequeue(entry))
+		{
+			// 待ち行列にあるエントリをワーカーが待つと、ワーカーが足りない場合にデッドロックするためその場で読み込む
+			_impl->load(entry);
+		}
+		entry.reset();
+
+		auto value = future.get();
+		future = {};
+		// 読み込みを完了したスレッドがロックを手放すまで待ち、戻り値以外の参照が残らないようにする
+		std::lock_guard lock{_impl->mutex};
+		return value;
+	}
+
+	std::shared_future<ref<void>> asset_cache::acquire_async(std::type_index type, string_view path)
+	{
+		std::shared_future<ref<void>> future;
+		ref<asset_entry> entry;
+		bool started = false;
+		if (auto value = _impl->request(type, path, future, entry, started))
+		{
+			std::promise<ref<void>> promise;
+			promise.set_value(std::move(value));
+			return promise.get_future().share();
+		}
+		if (started)
+		{
+			_impl->start(std::move(entry), false);
+		}
+		return future;
+	}
+
+	ref<void> asset_cache::find(std::type_index type, string_view path)
+	{
+		std::lock_guard lock{_impl->mutex};
+		const auto found = _impl->entries.find(entry_key_view{type, {path.data(), path.size()}});
+		if (found == _impl->entries.end() || !found->second->resident)
+		{
+			return nullptr;
+		}
+		_impl->lru.splice(_impl->lru.begin(), _impl->lru, found->second->lru);
+		return found->second->value;
+	}
+
+	void asset_cache::invalidate(string_view path)
+	{
+		const std::u32string_view key{path.data(), path.size()};
+		std::lock_guard lock{_impl->mutex};
+		for (auto it = _impl->entries.begin(); it != _impl->entries.end();)
+		{
+			const auto current = it++;
+			if (current->second->path == key)
+			{
+				_impl->drop(current);
+			}
+		}
+	}
+
+	void asset_cache::clear()
+	{
+		std::lock_guard lock{_impl->mutex};
+		while (!_impl->entries.empty())
+		{
+			_impl->drop(_impl->entries.begin());
+		}
+	}
+
+	void asset_cache::set_budget(size_t bytes)
+	{
+		std::lock_guard lock{_impl->mutex};
+		_impl->budget = bytes;
+		_impl->evict(nullptr, nullptr);
+	}
+
+	void asset_cache::set_budget(std::type_index type, size_t bytes)
+	{
+		std::lock_guard lock{_impl->mutex};
+		const auto state = _impl->types.find(type);
+		PUPPY_EXPECTS(state != _impl->types.end());
+		state->second.stats.budget = bytes;
+		_impl->evict(&type, nullptr);
+	}
+
+	asset_cache_stats asset_cache::stats() const
+	{
+		std::lock_guard lock{_impl->mutex};
+		asset_cache_stats result;
+		result.budget = _impl->budget;
+		for (const auto& [type, state] : _impl->types)
+		{
+			const auto& stats = state.stats;
+			result.hits += stats.hits;
+			result.merged += stats.merged;
+			result.misses += stats.misses;
+			result.failures += stats.failures;
+			result.evictions += stats.evictions;
+			result.reloads += stats.reloads;
+			result.resident_bytes += stats.resident_bytes;
+			result.resident_count += stats.resident_count;
+			for (size_t i = 0; i < asset_cache_stats::latency_bucket_count; ++i)
+			{
+				result.load_latency[i] += stats.load_latency[i];
+			}
+		}
+		return result;
+	}
+
+	asset_cache_stats asset_cache::stats(std::type_index type) const
+	{
+		std::lock_guard lock{_impl->mutex};
+		const auto state = _impl->types.find(type);
+		return state != _impl->types.end() ? state->second.stats : asset_cache_stats{};
+	}
+}
@@ -0,0 +1,163 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <puppy/core/serialization.hpp>
+#include <bit>
+
+namespace puppy
+{
+	namespace
+	{
+		// --- CRC-32C (slicing-by-8) のテーブル
+		constexpr std::uint32_t crc32c_polynomial = 0x82F63B78;
+
+		constexpr auto crc32c_tables = []
+		{
+			std::array<std::array<std::uint32_t, 256>, 8> tables{};
+			for (std::uint32_t i = 0; i < 256; ++i)
+			{
+				std::uint32_t crc = i;
+				for (int bit = 0; bit < 8; ++bit)
+				{
+					crc = (crc >> 1) ^ (crc32c_polynomial & (0 - (crc & 1)));
+				}
+				tables[0][i] = crc;
+			}
+			for (std::uint32_t i = 0; i < 256; ++i)
+			{
+				for (size_t slice = 1; slice < 8; ++slice)
+				{
+					const auto prev = tables[slice - 1][i];
+					tables[slice][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+				}
+			}
+			return tables;
+		}();
+
+		constexpr std::uint16_t native_endian_flag =
+			std::endian::native == std::endian::big ? detail::serialized_flag_big : 0;
+
+		PUPPY_FORCE_INLINE
+		std::uint32_t load_le32(const byte_t* p) noexcept
+		{
+			return std::to_integer<std::uint32_t>(p[0])
+			     | std::to_integer<std::uint32_t>(p[1]) << 8
+			     | std::to_integer<std::uint32_t>(p[2]) << 16
+			     | std::to_integer<std::uint32_t>(p[3]) << 24;
+		}
+
+		detail::serialized_header load_header(std::span<const byte_t> buffer) noexcept
+		{
+			detail::serialized_header header;
+			std::memcpy(&header, buffer.data(), sizeof(header));
+			return header;
+		}
+	}
+
+	std::uint32_t crc32c(std::span<const byte_t> data, std::uint32_t crc) noexcept
+	{
+		const auto& t = crc32c_tables;
+		const byte_t* p = data.data();
+		size_t size = data.size();
+
+		crc = ~crc;
+
+		// 8バイトずつ処理する
+		while (size >= 8)
+		{
+			const std::uint32_t lo = load_le32(p) ^ crc;
+			const std::uint32_t hi = load_le32(p + 4);
+			crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+			    ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+			p += 8;
+			size -= 8;
+		}
+
+		// 残りを1バイトずつ処理する
+		while (size-- > 0)
+		{
+			crc = (crc >> 8) ^ t[0][(crc ^ std::to_integer<std::uint32_t>(*p++)) & 0xFF];
+		}
+
+		return ~crc;
+	}
+
+	serialized_status verify_serialized(std::span<const byte_t> buffer, bool verify_checksum) noexcept
+	{
+		if (buffer.size() < sizeof(detail::serialized_header))
+		{
+			return serialized_status::too_small;
+		}
+		if (reinterpret_cast<std::uintptr_t>(buffer.data()) % serialized_alignment != 0)
+		{
+			return serialized_status::misaligned;
+		}
+
+		const auto header = load_header(buffer);
+		if (header.magic != detail::serialized_magic)
+		{
+			return serialized_status::bad_magic;
+		}
+		if (header.format != detail::serialized_format)
+		{
+			return serialized_status::unsupported_format;
+		}
+		if ((header.flags & detail::serialized_flag_big) != native_endian_flag)
+		{
+			return serialized_status::endian_mismatch;
+		}
+		if (header.size < sizeof(detail::serialized_header) || buffer.size() < header.size)
+		{
+			return serialized_status::truncated;
+		}
+		if (header.root < sizeof(detail::serialized_header)
+			|| header.root % alignof(std::uint32_t) != 0
+			|| size_t{header.root} + sizeof(std::uint32_t) > header.size)
+		{
+			return serialized_status::bad_root;
+		}
+		if (verify_checksum && (header.flags & detail::serialized_flag_checksum) != 0)
+		{
+			const auto body = buffer.subspan(sizeof(detail::serialized_header),
+				header.size - sizeof(detail::serialized_header));
+			if (crc32c(body) != header.checksum)
+			{
+				return serialized_status::checksum_mismatch;
+			}
+		}
+
+		return serialized_status::ok;
+	}
+}
+
+namespace puppy::detail
+{
+	void finish_serialized(std::span<byte_t> buffer,
+		std::uint32_t root, std::uint32_t schema_version, bool checksum) noexcept
+	{
+		PUPPY_EXPECTS(buffer.size() >= sizeof(serialized_header));
+
+		serialized_header header{};
+		header.magic          = serialized_magic;
+		header.format         = serialized_format;
+		header.flags          = native_endian_flag;
+		header.schema_version = schema_version;
+		header.size           = static_cast<std::uint32_t>(buffer.size());
+		header.root           = root;
+
+		if (checksum)
+		{
+			header.flags   |= serialized_flag_checksum;
+			header.checksum = crc32c(buffer.subspan(sizeof(serialized_header)));
+		}
+
+		std::memcpy(buffer.data(), &header, sizeof(header));
+	}
+}
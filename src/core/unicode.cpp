@@ -0,0 +1,775 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <puppy/core/unicode.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#if PUPPY_INTRINSIC_SSE2
+	#include <emmintrin.h>
+#endif
+
+// tools/generate_unicode_tables.pyで生成してリポジトリに含める (CMakeのPUPPY_GENERATE_UNICODE_TABLESで再生成する)
+#include "unicode_tables.inc"
+
+namespace puppy
+{
+	namespace
+	{
+		namespace tables = detail::unicode_tables;
+
+		// --- 書記素クラスタ境界プロパティ (生成スクリプトと同じ順序)
+		enum class grapheme_break : std::uint8_t
+		{
+			other, cr, lf, control, extend, zwj, regional_indicator,
+			prepend, spacing_mark, l, v, t, lv, lvt,
+		};
+
+		// --- 単語境界プロパティ (生成スクリプトと同じ順序)
+		enum class word_break : std::uint8_t
+		{
+			other, cr, lf, newline, extend, zwj, regional_indicator,
+			format, katakana, hebrew_letter, aletter, single_quote,
+			double_quote, mid_num_let, mid_letter, mid_num, numeric,
+			extend_num_let, wseg_space,
+		};
+
+		// --- ハングル音節
+		constexpr char32_t hangul_s_base  = 0xAC00;
+		constexpr char32_t hangul_l_base  = 0x1100;
+		constexpr char32_t hangul_v_base  = 0x1161;
+		constexpr char32_t hangul_t_base  = 0x11A7;
+		constexpr char32_t hangul_l_count = 19;
+		constexpr char32_t hangul_v_count = 21;
+		constexpr char32_t hangul_t_count = 28;
+		constexpr char32_t hangul_n_count = hangul_v_count * hangul_t_count;
+		constexpr char32_t hangul_s_count = hangul_l_count * hangul_n_count;
+
+		/// @brief 2段テーブルを引く
+		template<class TStage1, size_t N1, class TStage2, size_t N2>
+		PUPPY_FORCE_INLINE
+		auto lookup(const TStage1 (&stage1)[N1], const TStage2 (&stage2)[N2],
+			unsigned shift, char32_t c) noexcept
+		{
+			// 範囲外の値は非文字として扱う
+			c = c <= 0x10FFFF ? c : 0x10FFFF;
+			const size_t block = stage1[c >> shift];
+			return stage2[(block << shift) | (c & ((1u << shift) - 1))];
+		}
+
+		/// @brief 文字プロパティのレコードを返す
+		PUPPY_FORCE_INLINE
+		std::uint32_t properties(char32_t c) noexcept
+		{
+			return tables::property_records[
+				lookup(tables::property_stage1, tables::property_stage2, tables::property_shift, c)];
+		}
+
+		PUPPY_FORCE_INLINE
+		std::uint8_t combining_class(char32_t c) noexcept
+		{
+			return c < 0x300 ? 0 : static_cast<std::uint8_t>(properties(c) & 0xFF);
+		}
+
+		PUPPY_FORCE_INLINE
+		grapheme_break grapheme_break_of(std::uint32_t props) noexcept
+		{
+			return static_cast<grapheme_break>((props >> 8) & 0xF);
+		}
+
+		PUPPY_FORCE_INLINE
+		word_break word_break_of(std::uint32_t props) noexcept
+		{
+			return static_cast<word_break>((props >> 12) & 0x1F);
+		}
+
+		PUPPY_FORCE_INLINE
+		bool is_extended_pictographic(std::uint32_t props) noexcept
+		{
+			return (props >> 17) & 1;
+		}
+
+		PUPPY_FORCE_INLINE
+		normalization_check quick_check_of(std::uint32_t props, normalization_form form) noexcept
+		{
+			if (form == normalization_form::nfc)
+			{
+				return static_cast<normalization_check>((props >> 18) & 0x3);
+			}
+			return (props >> 20) & 1 ? normalization_check::no : normalization_check::yes;
+		}
+
+		PUPPY_FORCE_INLINE
+		char32_t ascii_case_fold(char32_t c) noexcept
+		{
+			return c - U'A' < 26 ? c + 0x20 : c;
+		}
+
+#if PUPPY_INTRINSIC_SSE2
+		/// @brief 4つのコードポイントが全てASCII文字であるか
+		PUPPY_FORCE_INLINE
+		bool is_ascii(__m128i v) noexcept
+		{
+			const __m128i non_ascii = _mm_and_si128(v, _mm_set1_epi32(~0x7F));
+			return _mm_movemask_epi8(_mm_cmpeq_epi32(non_ascii, _mm_setzero_si128())) == 0xFFFF;
+		}
+#endif
+
+		/// @brief 先頭から連続するASCII文字の数を返す
+		size_t ascii_prefix_length(const char32_t* str, size_t size) noexcept
+		{
+			size_t i = 0;
+#if PUPPY_INTRINSIC_SSE2
+			for (; i + 8 <= size; i += 8)
+			{
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i + 4));
+				if (!is_ascii(_mm_or_si128(a, b)))
+				{
+					break;
+				}
+			}
+#endif
+			while (i < size && str[i] < 0x80)
+			{
+				++i;
+			}
+			return i;
+		}
+
+		/// @brief ASCII文字が続く間、ケースフォールディングした結果が等しい文字数を返す
+		size_t ascii_case_insensitive_prefix(const char32_t* lhs, const char32_t* rhs, size_t size) noexcept
+		{
+			size_t i = 0;
+#if PUPPY_INTRINSIC_SSE2
+			const __m128i upper_a   = _mm_set1_epi32(U'A' - 1);
+			const __m128i upper_z   = _mm_set1_epi32(U'Z' + 1);
+			const __m128i offset    = _mm_set1_epi32(0x20);
+			const auto fold = [&](__m128i v)
+			{
+				const __m128i upper = _mm_and_si128(_mm_cmpgt_epi32(v, upper_a), _mm_cmplt_epi32(v, upper_z));
+				return _mm_add_epi32(v, _mm_and_si128(upper, offset));
+			};
+			for (; i + 4 <= size; i += 4)
+			{
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+				if (!is_ascii(_mm_or_si128(a, b))
+					|| _mm_movemask_epi8(_mm_cmpeq_epi32(fold(a), fold(b))) != 0xFFFF)
+				{
+					break;
+				}
+			}
+#endif
+			while (i < size && (lhs[i] | rhs[i]) < 0x80 && ascii_case_fold(lhs[i]) == ascii_case_fold(rhs[i]))
+			{
+				++i;
+			}
+			return i;
+		}
+
+		/// @brief 完全ケースフォールディングした文字を1文字ずつ返す
+		class fold_cursor final
+		{
+		public:
+			fold_cursor(const char32_t* first, const char32_t* last) noexcept
+				: _first{first}, _last{last}
+			{}
+
+			bool next(char32_t& out) noexcept
+			{
+				if (_index < _size)
+				{
+					out = _buffer[_index++];
+					return true;
+				}
+				if (_first == _last)
+				{
+					return false;
+				}
+
+				const char32_t c = *_first++;
+				if (c < 0x80) PUPPY_LIKELY
+				{
+					out = ascii_case_fold(c);
+					return true;
+				}
+				_size = full_case_fold(c, _buffer);
+				_index = 1;
+				out = _buffer[0];
+				return true;
+			}
+
+		private:
+			const char32_t* _first;
+			const char32_t* _last;
+			char32_t _buffer[max_case_fold_length]{};
+			size_t _size = 0;
+			size_t _index = 0;
+		};
+
+		// --- 正規化
+
+		void decompose(char32_t c, std::u32string& out)
+		{
+			if (c - hangul_s_base < hangul_s_count)
+			{
+				const char32_t index = c - hangul_s_base;
+				out.push_back(hangul_l_base + index / hangul_n_count);
+				out.push_back(hangul_v_base + (index % hangul_n_count) / hangul_t_count);
+				if (index % hangul_t_count != 0)
+				{
+					out.push_back(hangul_t_base + index % hangul_t_count);
+				}
+				return;
+			}
+
+			const size_t index = lookup(tables::decomposition_stage1, tables::decomposition_stage2,
+				tables::decomposition_shift, c);
+			if (index == 0)
+			{
+				out.push_back(c);
+				return;
+			}
+			const char32_t* data = tables::decomposition_data + index;
+			out.append(data + 1, data[0]);
+		}
+
+		/// @brief 結合文字を結合クラス順に安定ソートする
+		void canonical_order(std::u32string& str, size_t first)
+		{
+			for (size_t i = first + 1; i < str.size(); ++i)
+			{
+				const char32_t c = str[i];
+				const auto ccc = combining_class(c);
+				if (ccc == 0)
+				{
+					continue;
+				}
+				size_t j = i;
+				while (j > first && combining_class(str[j - 1]) > ccc)
+				{
+					str[j] = str[j - 1];
+					--j;
+				}
+				str[j] = c;
+			}
+		}
+
+		char32_t compose_pair(char32_t first, char32_t second) noexcept
+		{
+			// ハングル L + V
+			if (first - hangul_l_base < hangul_l_count && second - hangul_v_base < hangul_v_count)
+			{
+				return hangul_s_base
+					+ ((first - hangul_l_base) * hangul_v_count + (second - hangul_v_base)) * hangul_t_count;
+			}
+			// ハングル LV + T
+			if (first - hangul_s_base < hangul_s_count && (first - hangul_s_base) % hangul_t_count == 0
+				&& second - hangul_t_base - 1 < hangul_t_count - 1)
+			{
+				return first + (second - hangul_t_base);
+			}
+
+			const std::uint64_t key = std::uint64_t{first} << 21 | second;
+			const auto keys = std::begin(tables::composition_keys);
+			const auto it = std::lower_bound(keys, std::end(tables::composition_keys), key);
+			if (it == std::end(tables::composition_keys) || *it != key)
+			{
+				return 0;
+			}
+			return tables::composition_values[it - keys];
+		}
+
+		void canonical_compose(std::u32string& str)
+		{
+			if (str.empty())
+			{
+				return;
+			}
+
+			size_t starter_pos = 0;
+			char32_t starter = str[0];
+			int last_class = combining_class(starter) == 0 ? 0 : 256;
+			size_t write = 1;
+			for (size_t read = 1; read < str.size(); ++read)
+			{
+				const char32_t c = str[read];
+				const int ccc = combining_class(c);
+				const char32_t composite = last_class != 256 ? compose_pair(starter, c) : 0;
+				if (composite != 0 && (last_class < ccc || last_class == 0))
+				{
+					str[starter_pos] = composite;
+					starter = composite;
+					continue;
+				}
+				if (ccc == 0)
+				{
+					starter_pos = write;
+					starter = c;
+				}
+				last_class = ccc;
+				str[write++] = c;
+			}
+			str.resize(write);
+		}
+
+		// --- 単語境界
+
+		PUPPY_FORCE_INLINE
+		bool is_ignorable(word_break wb) noexcept
+		{
+			return wb == word_break::extend || wb == word_break::format || wb == word_break::zwj;
+		}
+
+		PUPPY_FORCE_INLINE
+		bool is_ahletter(word_break wb) noexcept
+		{
+			return wb == word_break::aletter || wb == word_break::hebrew_letter;
+		}
+
+		PUPPY_FORCE_INLINE
+		bool is_mid_letter_q(word_break wb) noexcept
+		{
+			return wb == word_break::mid_letter || wb == word_break::mid_num_let || wb == word_break::single_quote;
+		}
+
+		PUPPY_FORCE_INLINE
+		bool is_mid_num_q(word_break wb) noexcept
+		{
+			return wb == word_break::mid_num || wb == word_break::mid_num_let || wb == word_break::single_quote;
+		}
+
+		/// @brief 無視できる文字を飛ばした次の文字の単語境界プロパティを返す
+		word_break next_word_break(const char32_t* str, size_t size, size_t pos) noexcept
+		{
+			for (; pos < size; ++pos)
+			{
+				const auto wb = word_break_of(properties(str[pos]));
+				if (!is_ignorable(wb))
+				{
+					return wb;
+				}
+			}
+			return word_break::other;
+		}
+	}
+
+	char32_t simple_case_fold(char32_t c) noexcept
+	{
+		if (c < 0x80) PUPPY_LIKELY
+		{
+			return ascii_case_fold(c);
+		}
+		const auto index = lookup(tables::fold_stage1, tables::fold_stage2, tables::fold_shift, c);
+		return static_cast<char32_t>(static_cast<std::int32_t>(c) + tables::fold_deltas[index]);
+	}
+
+	size_t full_case_fold(char32_t c, char32_t* out) noexcept
+	{
+		PUPPY_EXPECTS(out != nullptr);
+		if (c < 0x80) PUPPY_LIKELY
+		{
+			out[0] = ascii_case_fold(c);
+			return 1;
+		}
+
+		const auto index = lookup(tables::fold_stage1, tables::fold_stage2, tables::fold_shift, c);
+		const auto expansion = tables::fold_expansion_indices[index];
+		if (expansion == 0)
+		{
+			out[0] = static_cast<char32_t>(static_cast<std::int32_t>(c) + tables::fold_deltas[index]);
+			return 1;
+		}
+
+		const char32_t* data = tables::fold_expansions + expansion * 4;
+		std::copy_n(data + 1, data[0], out);
+		return data[0];
+	}
+
+	int compare_case_insensitive(string_view lhs, string_view rhs) noexcept
+	{
+		const size_t prefix = ascii_case_insensitive_prefix(
+			lhs.data(), rhs.data(), std::min(lhs.size(), rhs.size()));
+
+		fold_cursor left{lhs.data() + prefix, lhs.data() + lhs.size()};
+		fold_cursor right{rhs.data() + prefix, rhs.data() + rhs.size()};
+		while (true)
+		{
+			char32_t a, b;
+			const bool has_left = left.next(a);
+			const bool has_right = right.next(b);
+			if (!has_left || !has_right)
+			{
+				return has_left ? 1 : has_right ? -1 : 0;
+			}
+			if (a != b)
+			{
+				return a < b ? -1 : 1;
+			}
+		}
+	}
+
+	bool equals_case_insensitive(string_view lhs, string_view rhs) noexcept
+	{
+		// ASCIIのみであれば長さが異なる時点で等しくない
+		if (lhs.size() != rhs.size()
+			&& ascii_prefix_length(lhs.data(), lhs.size()) == lhs.size()
+			&& ascii_prefix_length(rhs.data(), rhs.size()) == rhs.size())
+		{
+			return false;
+		}
+		return compare_case_insensitive(lhs, rhs) == 0;
+	}
+
+	size_t hash_case_insensitive(string_view sv) noexcept
+	{
+		// FNV-1a
+		std::uint64_t hash = 0xCBF29CE484222325;
+		const auto mix = [&hash](char32_t c)
+		{
+			hash = (hash ^ c) * 0x100000001B3;
+		};
+
+		const char32_t* str = sv.data();
+		size_t size = sv.size();
+		while (size != 0)
+		{
+			const size_t ascii = ascii_prefix_length(str, size);
+			for (size_t i = 0; i < ascii; ++i)
+			{
+				mix(ascii_case_fold(str[i]));
+			}
+			str += ascii;
+			size -= ascii;
+
+			if (size != 0)
+			{
+				char32_t buffer[max_case_fold_length];
+				const size_t count = full_case_fold(*str++, buffer);
+				for (size_t i = 0; i < count; ++i)
+				{
+					mix(buffer[i]);
+				}
+				--size;
+			}
+		}
+		return static_cast<size_t>(hash);
+	}
+
+	normalization_check quick_check(string_view sv, normalization_form form) noexcept
+	{
+		// ASCIIはどの正規化形式でも正規化済み
+		const size_t prefix = ascii_prefix_length(sv.data(), sv.size());
+
+		auto result = normalization_check::yes;
+		std::uint8_t last_class = 0;
+		for (size_t i = prefix; i < sv.size(); ++i)
+		{
+			const char32_t c = sv[i];
+			if (c < 0x80)
+			{
+				last_class = 0;
+				continue;
+			}
+
+			const auto props = properties(c);
+			const auto ccc = static_cast<std::uint8_t>(props & 0xFF);
+			if (ccc != 0 && last_class > ccc)
+			{
+				return normalization_check::no;
+			}
+			const auto check = quick_check_of(props, form);
+			if (check == normalization_check::no)
+			{
+				return normalization_check::no;
+			}
+			if (check == normalization_check::maybe)
+			{
+				result = normalization_check::maybe;
+			}
+			last_class = ccc;
+		}
+		return result;
+	}
+
+	bool is_normalized(string_view sv, normalization_form form)
+	{
+		switch (quick_check(sv, form))
+		{
+		case normalization_check::yes:
+			return true;
+		case normalization_check::no:
+			return false;
+		case normalization_check::maybe:
+			break;
+		}
+		const auto normalized = normalize(sv, form);
+		return string_view{normalized.data(), normalized.size()}.compare(sv) == 0;
+	}
+
+	std::u32string normalize(string_view sv, normalization_form form)
+	{
+		if (quick_check(sv, form) == normalization_check::yes)
+		{
+			return {sv.data(), sv.size()};
+		}
+
+		std::u32string result;
+		result.reserve(sv.size() + sv.size() / 2);
+
+		// ASCIIの並びはそのままコピーする
+		// 最後のASCII文字は後続の結合文字と合成される可能性があるため分解の対象に含める
+		const size_t prefix = ascii_prefix_length(sv.data(), sv.size());
+		const size_t first = prefix == 0 ? 0 : prefix - 1;
+		result.append(sv.data(), first);
+		for (size_t i = first; i < sv.size(); ++i)
+		{
+			decompose(sv[i], result);
+		}
+		canonical_order(result, first);
+
+		if (form == normalization_form::nfc)
+		{
+			canonical_compose(result);
+		}
+		return result;
+	}
+
+	size_t next_grapheme_boundary(string_view text, size_t pos) noexcept
+	{
+		const char32_t* str = text.data();
+		const size_t size = text.size();
+		if (pos >= size)
+		{
+			return size;
+		}
+
+		char32_t prev_char = str[pos];
+		auto prev = grapheme_break_of(properties(prev_char));
+		size_t ri_count = prev == grapheme_break::regional_indicator ? 1 : 0;
+		// 0: なし, 1: Extended_Pictographic Extend*, 2: Extended_Pictographic Extend* ZWJ
+		int emoji_state = is_extended_pictographic(properties(prev_char)) ? 1 : 0;
+
+		for (size_t i = pos + 1; i < size; ++i)
+		{
+			const char32_t c = str[i];
+
+			// ASCII同士はCR LFを除いて常に境界
+			if ((prev_char | c) < 0x80) PUPPY_LIKELY
+			{
+				if (prev_char != U'\r' || c != U'\n')
+				{
+					return i;
+				}
+				prev_char = c;
+				prev = grapheme_break::lf;
+				continue;
+			}
+
+			const auto props = properties(c);
+			const auto cur = grapheme_break_of(props);
+			const bool pictographic = is_extended_pictographic(props);
+
+			bool boundary;
+			if (prev == grapheme_break::cr && cur == grapheme_break::lf)                   // GB3
+			{
+				boundary = false;
+			}
+			else if (prev == grapheme_break::control || prev == grapheme_break::cr
+				|| prev == grapheme_break::lf)                                               // GB4
+			{
+				boundary = true;
+			}
+			else if (cur == grapheme_break::control || cur == grapheme_break::cr
+				|| cur == grapheme_break::lf)                                                // GB5
+			{
+				boundary = true;
+			}
+			else if (prev == grapheme_break::l && (cur == grapheme_break::l || cur == grapheme_break::v
+				|| cur == grapheme_break::lv || cur == grapheme_break::lvt))                 // GB6
+			{
+				boundary = false;
+			}
+			else if ((prev == grapheme_break::lv || prev == grapheme_break::v)
+				&& (cur == grapheme_break::v || cur == grapheme_break::t))                   // GB7
+			{
+				boundary = false;
+			}
+			else if ((prev == grapheme_break::lvt || prev == grapheme_break::t)
+				&& cur == grapheme_break::t)                                                 // GB8
+			{
+				boundary = false;
+			}
+			else if (cur == grapheme_break::extend || cur == grapheme_break::zwj
+				|| cur == grapheme_break::spacing_mark || prev == grapheme_break::prepend)   // GB9, GB9a, GB9b
+			{
+				boundary = false;
+			}
+			else if (emoji_state == 2 && pictographic)                                        // GB11
+			{
+				boundary = false;
+			}
+			else if (prev == grapheme_break::regional_indicator
+				&& cur == grapheme_break::regional_indicator)                                // GB12, GB13
+			{
+				boundary = ri_count % 2 == 0;
+			}
+			else                                                                              // GB999
+			{
+				boundary = true;
+			}
+
+			if (boundary)
+			{
+				return i;
+			}
+
+			ri_count = cur == grapheme_break::regional_indicator ? ri_count + 1 : 0;
+			emoji_state = pictographic ? 1
+				: emoji_state == 1 && cur == grapheme_break::extend ? 1
+				: emoji_state == 1 && cur == grapheme_break::zwj ? 2
+				: 0;
+			prev_char = c;
+			prev = cur;
+		}
+		return size;
+	}
+
+	size_t next_word_boundary(string_view text, size_t pos) noexcept
+	{
+		const char32_t* str = text.data();
+		const size_t size = text.size();
+		if (pos >= size)
+		{
+			return size;
+		}
+
+		// raw: WB4を適用する前の直前の文字, prev / prev2: WB4を適用した後の直前の文字
+		auto raw = word_break_of(properties(str[pos]));
+		auto prev = raw;
+		auto prev2 = word_break::other;
+		size_t ri_count = prev == word_break::regional_indicator ? 1 : 0;
+
+		for (size_t i = pos + 1; i < size; ++i)
+		{
+			const auto props = properties(str[i]);
+			const auto cur = word_break_of(props);
+
+			bool boundary;
+			bool ignore = false;
+			if (raw == word_break::cr && cur == word_break::lf)                                 // WB3
+			{
+				boundary = false;
+			}
+			else if (raw == word_break::newline || raw == word_break::cr || raw == word_break::lf) // WB3a
+			{
+				boundary = true;
+			}
+			else if (cur == word_break::newline || cur == word_break::cr || cur == word_break::lf) // WB3b
+			{
+				boundary = true;
+			}
+			else if (raw == word_break::zwj && is_extended_pictographic(props))                    // WB3c
+			{
+				boundary = false;
+			}
+			else if (raw == word_break::wseg_space && cur == word_break::wseg_space)               // WB3d
+			{
+				boundary = false;
+			}
+			else if (is_ignorable(cur))                                                          // WB4
+			{
+				boundary = false;
+				ignore = true;
+			}
+			else if (is_ahletter(prev) && is_ahletter(cur))                                       // WB5
+			{
+				boundary = false;
+			}
+			else if (is_ahletter(prev) && is_mid_letter_q(cur)
+				&& is_ahletter(next_word_break(str, size, i + 1)))                                // WB6
+			{
+				boundary = false;
+			}
+			else if (is_ahletter(prev2) && is_mid_letter_q(prev) && is_ahletter(cur))             // WB7
+			{
+				boundary = false;
+			}
+			else if (prev == word_break::hebrew_letter && cur == word_break::single_quote)        // WB7a
+			{
+				boundary = false;
+			}
+			else if (prev == word_break::hebrew_letter && cur == word_break::double_quote
+				&& next_word_break(str, size, i + 1) == word_break::hebrew_letter)                // WB7b
+			{
+				boundary = false;
+			}
+			else if (prev2 == word_break::hebrew_letter && prev == word_break::double_quote
+				&& cur == word_break::hebrew_letter)                                              // WB7c
+			{
+				boundary = false;
+			}
+			else if ((prev == word_break::numeric || is_ahletter(prev))
+				&& (cur == word_break::numeric || is_ahletter(cur)))                              // WB8, WB9, WB10
+			{
+				boundary = false;
+			}
+			else if (prev2 == word_break::numeric && is_mid_num_q(prev)
+				&& cur == word_break::numeric)                                                    // WB11
+			{
+				boundary = false;
+			}
+			else if (prev == word_break::numeric && is_mid_num_q(cur)
+				&& next_word_break(str, size, i + 1) == word_break::numeric)                      // WB12
+			{
+				boundary = false;
+			}
+			else if (prev == word_break::katakana && cur == word_break::katakana)                 // WB13
+			{
+				boundary = false;
+			}
+			else if ((is_ahletter(prev) || prev == word_break::numeric || prev == word_break::katakana
+				|| prev == word_break::extend_num_let) && cur == word_break::extend_num_let)      // WB13a
+			{
+				boundary = false;
+			}
+			else if (prev == word_break::extend_num_let && (is_ahletter(cur)
+				|| cur == word_break::numeric || cur == word_break::katakana))                    // WB13b
+			{
+				boundary = false;
+			}
+			else if (prev == word_break::regional_indicator
+				&& cur == word_break::regional_indicator)                                         // WB15, WB16
+			{
+				boundary = ri_count % 2 == 0;
+			}
+			else                                                                                  // WB999
+			{
+				boundary = true;
+			}
+
+			if (boundary)
+			{
+				return i;
+			}
+
+			raw = cur;
+			if (!ignore)
+			{
+				ri_count = cur == word_break::regional_indicator ? ri_count + 1 : 0;
+				prev2 = prev;
+				prev = cur;
+			}
+		}
+		return size;
+	}
+}
@@ -0,0 +1,229 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <gtest/gtest.h>
+#include <puppy/core/allocation_tracker.hpp>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr puppy::allocation_category renderer{"test_renderer"};
+	constexpr puppy::allocation_category audio{"test_audio"};
+	constexpr puppy::allocation_category containers{"test_containers"};
+	constexpr puppy::allocation_category workers{"test_workers"};
+
+	struct base
+	{
+		virtual ~base() = default;
+	};
+
+	struct derived : base
+	{
+		char payload[64]{};
+	};
+}
+
+TEST(AllocationTracker, MakeFunctionsAcceptTags)
+{
+	// 追跡の有無に関わらず同じコードが使える
+	auto value = puppy::make_scope<int>(puppy::allocation_tag{renderer}, 42);
+	auto shared = puppy::make_ref<std::string>(PUPPY_ALLOCATION_TAG(renderer), "texture");
+	auto array = puppy::make_scope<int[]>(puppy::allocation_tag{renderer}, 4);
+	puppy::scope<base> converted = puppy::make_scope<derived>();
+	EXPECT_EQ(*value, 42);
+	EXPECT_EQ(*shared, "texture");
+	EXPECT_EQ(array[3], 0);
+	EXPECT_NE(converted, nullptr);
+
+	std::vector<int, puppy::tracking_allocator<int>> vector{puppy::tracking_allocator<int>{puppy::allocation_tag{containers}}};
+	vector.assign(16, 1);
+	EXPECT_EQ(vector.size(), 16u);
+
+	if constexpr (!puppy::allocation_tracking_enabled)
+	{
+		const auto snapshot = puppy::allocation_snapshot::capture();
+		EXPECT_TRUE(snapshot.sites().empty());
+		EXPECT_TRUE(snapshot.categories().empty());
+		EXPECT_EQ(sizeof(puppy::scope<int>), sizeof(int*));
+	}
+}
+
+TEST(AllocationTracker, ScopeAcceptsUniquePtr)
+{
+	// 追跡の有無に関わらず同じコードがコンパイルできる
+	const auto before = puppy::allocation_snapshot::capture();
+	{
+		const auto make = []() -> puppy::scope<int> { return std::make_unique<int>(1); };
+		puppy::scope<int> adopted = make();
+		puppy::scope<base> converted = std::make_unique<derived>();
+		puppy::scope<int[]> array = std::make_unique<int[]>(4);
+		puppy::scope<int> raw{new int{3}};
+		EXPECT_EQ(*adopted, 1);
+		EXPECT_NE(converted, nullptr);
+		EXPECT_EQ(array[3], 0);
+		EXPECT_EQ(*raw, 3);
+	}
+
+	if constexpr (puppy::allocation_tracking_enabled)
+	{
+		// make_scope以外で生成したポインタは解放時にタグのない割り当てとして記録する
+		const auto diff = puppy::allocation_snapshot::capture().diff(before);
+		const auto* category = diff.category("general");
+		ASSERT_NE(category, nullptr);
+		EXPECT_EQ(category->stats.allocations, 4u);
+		EXPECT_EQ(category->stats.deallocations, 4u);
+		EXPECT_EQ(category->stats.allocated_bytes, sizeof(int) * 2 + sizeof(base));
+		EXPECT_EQ(category->stats.live_bytes, 0);
+	}
+}
+
+#if PUPPY_ALLOCATION_TRACKING
+TEST(AllocationTracker, RecordsCategoryAndCallSite)
+{
+	const auto before = puppy::allocation_snapshot::capture();
+	auto value = puppy::make_scope<derived>(puppy::allocation_tag{renderer}); const auto line = __LINE__;
+	auto shared = puppy::make_ref<std::string>(puppy::allocation_tag{renderer}, "mesh");
+	const auto during = puppy::allocation_snapshot::capture();
+
+	const auto diff = during.diff(before);
+	const auto* category = diff.category("test_renderer");
+	ASSERT_NE(category, nullptr);
+	EXPECT_EQ(category->stats.allocations, 2u);
+	EXPECT_EQ(category->stats.deallocations, 0u);
+	EXPECT_GE(category->stats.live_bytes, static_cast<std::int64_t>(sizeof(derived) + sizeof(std::string)));
+	EXPECT_GT(diff.allocation_rate(*category), 0.0);
+
+	const auto site = std::find_if(diff.sites().begin(), diff.sites().end(),
+		[&](const puppy::allocation_record& record) { return record.category == "test_renderer" && record.line == line; });
+	ASSERT_NE(site, diff.sites().end());
+	EXPECT_NE(site->file.find("allocation_tracker"), std::string::npos);
+	EXPECT_EQ(site->stats.live_bytes, static_cast<std::int64_t>(sizeof(derived)));
+
+	// 基底クラスに変換しても割り当てたバイト数で解放を記録する
+	puppy::scope<base> converted = std::move(value);
+	converted.reset();
+	shared.reset();
+	const auto after = puppy::allocation_snapshot::capture().diff(before);
+	category = after.category("test_renderer");
+	ASSERT_NE(category, nullptr);
+	EXPECT_EQ(category->stats.deallocations, 2u);
+	EXPECT_EQ(category->stats.live_bytes, 0);
+	EXPECT_EQ(category->stats.live_count(), 0);
+	// 2つの時点の間のピークは分からない
+	EXPECT_EQ(category->stats.sampled_peak_bytes, 0);
+
+	// 標本化したピークはスナップショットを取得した時点で観測した最大値
+	const auto snapshot = puppy::allocation_snapshot::capture();
+	const auto* full = snapshot.category("test_renderer");
+	ASSERT_NE(full, nullptr);
+	EXPECT_GE(full->stats.sampled_peak_bytes, static_cast<std::int64_t>(sizeof(derived) + sizeof(std::string)));
+}
+
+TEST(AllocationTracker, TagMacroResolvesCallSiteOnce)
+{
+	const auto before = puppy::allocation_snapshot::capture();
+	std::vector<puppy::ref<int>> values;
+	for (int i = 0; i < 8; ++i)
+	{
+		values.push_back(puppy::make_ref<int>(PUPPY_ALLOCATION_TAG(audio), i)); const auto line = __LINE__;
+		if (i == 0)
+		{
+			const auto diff = puppy::allocation_snapshot::capture().diff(before);
+			ASSERT_EQ(diff.sites().size(), 1u);
+			EXPECT_EQ(diff.sites()[0].line, static_cast<std::uint32_t>(line));
+			EXPECT_NE(diff.sites()[0].function.find("TagMacroResolvesCallSiteOnce"), std::string::npos);
+		}
+	}
+
+	const auto diff = puppy::allocation_snapshot::capture().diff(before);
+	ASSERT_EQ(diff.sites().size(), 1u);
+	EXPECT_EQ(diff.sites()[0].stats.allocations, 8u);
+	EXPECT_EQ(diff.category("test_audio")->stats.allocations, 8u);
+}
+
+TEST(AllocationTracker, ScopeTagsUntaggedAllocations)
+{
+	const auto before = puppy::allocation_snapshot::capture();
+	std::vector<puppy::ref<int>> values;
+	{
+		puppy::allocation_scope scope{audio};
+		for (int i = 0; i < 10; ++i)
+		{
+			values.push_back(puppy::make_ref<int>(i));
+		}
+		// タグを指定した割り当てはスコープより優先される
+		values.push_back(puppy::make_ref<int>(puppy::allocation_tag{renderer}, 0));
+	}
+	values.push_back(puppy::make_ref<int>(0));
+
+	const auto diff = puppy::allocation_snapshot::capture().diff(before);
+	ASSERT_NE(diff.category("test_audio"), nullptr);
+	EXPECT_EQ(diff.category("test_audio")->stats.allocations, 10u);
+	EXPECT_EQ(diff.category("test_renderer")->stats.allocations, 1u);
+	EXPECT_EQ(diff.category("general")->stats.allocations, 1u);
+}
+
+TEST(AllocationTracker, TracksContainers)
+{
+	const auto before = puppy::allocation_snapshot::capture();
+	{
+		std::vector<int, puppy::tracking_allocator<int>> vector{puppy::tracking_allocator<int>{puppy::allocation_tag{containers}}};
+		vector.reserve(256);
+		const auto during = puppy::allocation_snapshot::capture().diff(before);
+		ASSERT_NE(during.category("test_containers"), nullptr);
+		EXPECT_EQ(during.category("test_containers")->stats.live_bytes, static_cast<std::int64_t>(256 * sizeof(int)));
+	}
+	const auto after = puppy::allocation_snapshot::capture().diff(before);
+	EXPECT_EQ(after.category("test_containers")->stats.live_bytes, 0);
+	EXPECT_EQ(after.category("test_containers")->stats.freed_bytes, 256 * sizeof(int));
+}
+
+TEST(AllocationTracker, MergesCountersOfExitedThreads)
+{
+	const auto before = puppy::allocation_snapshot::capture();
+	std::vector<puppy::ref<int>> values(4 * 100);
+	{
+		std::vector<std::jthread> threads;
+		for (size_t t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&values, t]
+			{
+				for (size_t i = 0; i < 100; ++i)
+				{
+					values[t * 100 + i] = puppy::make_ref<int>(PUPPY_ALLOCATION_TAG(workers), 0);
+				}
+			});
+		}
+	}
+	puppy::allocation_snapshot::sample_peaks();
+	// 別のスレッドで割り当てたオブジェクトを解放する
+	values.resize(100);
+
+	const auto diff = puppy::allocation_snapshot::capture().diff(before);
+	const auto* category = diff.category("test_workers");
+	ASSERT_NE(category, nullptr);
+	EXPECT_EQ(category->stats.allocations, 400u);
+	EXPECT_EQ(category->stats.deallocations, 300u);
+	EXPECT_EQ(category->stats.live_count(), 100);
+
+	const auto snapshot = puppy::allocation_snapshot::capture();
+	const auto* full = snapshot.category("test_workers");
+	ASSERT_NE(full, nullptr);
+	EXPECT_EQ(full->stats.live_bytes * 4, full->stats.sampled_peak_bytes);
+
+	std::ostringstream stream;
+	diff.dump(stream);
+	EXPECT_NE(stream.str().find("test_workers"), std::string::npos);
+}
+#endif
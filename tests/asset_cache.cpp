@@ -0,0 +1,268 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <gtest/gtest.h>
+#include <puppy/core/allocation_tracker.hpp>
+#include <puppy/core/asset_cache.hpp>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	namespace fs = std::filesystem;
+
+	/// @brief テストごとに一時ディレクトリを用意する
+	class AssetCache : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			_directory = fs::temp_directory_path() / ("puppy_asset_cache_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed())
+				+ "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+			fs::remove_all(_directory);
+			fs::create_directories(_directory);
+		}
+
+		void TearDown() override
+		{
+			fs::remove_all(_directory);
+		}
+
+		std::u32string write(const std::string& name, const std::string& content) const
+		{
+			const auto path = _directory / name;
+			std::ofstream{path, std::ios::binary} << content;
+			return path.u32string();
+		}
+
+		static puppy::string_view view(const std::u32string& str) noexcept
+		{
+			return {str.data(), str.size()};
+		}
+
+		/// @brief ファイルの内容を読み込み、呼び出し回数を数えるローダー
+		puppy::asset_loader<std::string> text_loader(std::chrono::milliseconds delay = {})
+		{
+			return [this, delay](const fs::path& path)
+			{
+				++_load_count;
+				std::this_thread::sleep_for(delay);
+				std::ifstream stream{path, std::ios::binary};
+				if (!stream)
+				{
+					return puppy::asset_data<std::string>{};
+				}
+				auto text = puppy::make_ref<std::string>(std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{});
+				const size_t bytes = text->size();
+				return puppy::asset_data<std::string>{std::move(text), bytes};
+			};
+		}
+
+		fs::path _directory;
+		std::atomic<int> _load_count = 0;
+	};
+}
+
+TEST_F(AssetCache, MergesConcurrentRequests)
+{
+	const auto path = write("config.txt", "value");
+	puppy::asset_cache cache{{.thread_count = 2}};
+	cache.register_loader<std::string>(text_loader(std::chrono::milliseconds{50}));
+
+	std::vector<puppy::ref<std::string>> results(8);
+	{
+		std::vector<std::jthread> threads;
+		for (auto& result : results)
+		{
+			threads.emplace_back([&] { result = cache.get<std::string>(view(path)); });
+		}
+	}
+
+	EXPECT_EQ(_load_count, 1);
+	for (const auto& result : results)
+	{
+		ASSERT_NE(result, nullptr);
+		EXPECT_EQ(result, results[0]);
+		EXPECT_EQ(*result, "value");
+	}
+
+	const auto stats = cache.stats();
+	EXPECT_EQ(stats.misses, 1u);
+	EXPECT_EQ(stats.hits + stats.merged, 7u);
+	EXPECT_DOUBLE_EQ(stats.hit_rate(), 7.0 / 8.0);
+	EXPECT_EQ(stats.resident_bytes, 5u);
+	EXPECT_EQ(stats.load_latency[15] + stats.load_latency[16], 1u);
+}
+
+TEST_F(AssetCache, AsyncLoadAndFailure)
+{
+	const auto path = write("a.txt", "abc");
+	puppy::asset_cache cache;
+	cache.register_loader<std::string>(text_loader());
+
+	auto future = cache.load<std::string>(view(path));
+	EXPECT_EQ(*future.get(), "abc");
+	EXPECT_TRUE(cache.load<std::string>(view(path)).ready());
+
+	// 失敗した読み込みは保持しない
+	const std::u32string missing = (_directory / "missing.txt").u32string();
+	EXPECT_EQ(cache.get<std::string>(view(missing)), nullptr);
+	EXPECT_EQ(cache.get<std::string>(view(missing)), nullptr);
+	EXPECT_EQ(cache.stats<std::string>().failures, 2u);
+	EXPECT_EQ(cache.find<std::string>(view(missing)), nullptr);
+}
+
+TEST_F(AssetCache, EvictsLeastRecentlyUsed)
+{
+	const auto a = write("a.txt", "aaaa");
+	const auto b = write("b.txt", "bbbb");
+	const auto c = write("c.txt", "cccc");
+	puppy::asset_cache cache{{.budget = 10, .thread_count = 1}};
+	cache.register_loader<std::string>(text_loader());
+
+	(void)cache.get<std::string>(view(a));
+	(void)cache.get<std::string>(view(b));
+	(void)cache.get<std::string>(view(a));
+	(void)cache.get<std::string>(view(c));
+
+	EXPECT_NE(cache.find<std::string>(view(a)), nullptr);
+	EXPECT_EQ(cache.find<std::string>(view(b)), nullptr);
+	EXPECT_NE(cache.find<std::string>(view(c)), nullptr);
+	EXPECT_EQ(cache.stats().evictions, 1u);
+	EXPECT_EQ(cache.stats().resident_bytes, 8u);
+
+	// キャッシュの外で参照されているエントリは追い出さない
+	const auto held = cache.get<std::string>(view(a));
+	cache.set_budget(0);
+	EXPECT_EQ(cache.find<std::string>(view(a)), held);
+	EXPECT_EQ(cache.find<std::string>(view(c)), nullptr);
+}
+
+TEST_F(AssetCache, PerTypeBudget)
+{
+	struct blob { std::string data; };
+	const auto a = write("a.bin", "0123456789");
+	const auto b = write("b.bin", "0123456789");
+	puppy::asset_cache cache{{.thread_count = 1}};
+	cache.register_loader<std::string>(text_loader());
+	cache.register_loader<blob>([](const fs::path& path)
+	{
+		std::ifstream stream{path, std::ios::binary};
+		auto value = puppy::make_ref<blob>(std::string{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}});
+		const size_t bytes = value->data.size();
+		return puppy::asset_data<blob>{std::move(value), bytes};
+	}, 15);
+
+	(void)cache.get<blob>(view(a));
+	(void)cache.get<blob>(view(b));
+	(void)cache.get<std::string>(view(a));
+	(void)cache.get<std::string>(view(b));
+
+	EXPECT_EQ(cache.stats<blob>().resident_count, 1u);
+	EXPECT_EQ(cache.stats<blob>().evictions, 1u);
+	EXPECT_EQ(cache.stats<std::string>().resident_count, 2u);
+	EXPECT_EQ(cache.stats().resident_bytes, 30u);
+
+	cache.invalidate(view(b));
+	EXPECT_EQ(cache.stats().resident_count, 1u);
+	cache.clear();
+	EXPECT_EQ(cache.stats().resident_bytes, 0u);
+}
+
+#if PUPPY_ALLOCATION_TRACKING
+TEST_F(AssetCache, TagsAllocations)
+{
+	const auto path = write("a.txt", "abc");
+	const auto before = puppy::allocation_snapshot::capture();
+	{
+		puppy::asset_cache cache{{.thread_count = 1}};
+		cache.register_loader<std::string>(text_loader());
+		(void)cache.get<std::string>(view(path));
+	}
+	const auto diff = puppy::allocation_snapshot::capture().diff(before);
+	const auto* category = diff.category("asset_cache");
+	ASSERT_NE(category, nullptr);
+	// キャッシュ本体、ファイルの監視 (Linuxのみ)、エントリ
+	EXPECT_EQ(category->stats.allocations, PUPPY_PLATFORM_LINUX ? 3u : 2u);
+	EXPECT_EQ(category->stats.live_bytes, 0);
+}
+#endif
+
+TEST_F(AssetCache, ThrowingLoaderFails)
+{
+	const auto path = write("broken.txt", "");
+	puppy::asset_cache cache{{.thread_count = 1}};
+	cache.register_loader<std::string>([](const fs::path&) -> puppy::asset_data<std::string>
+	{
+		throw std::runtime_error{"broken"};
+	});
+
+	EXPECT_EQ(cache.get<std::string>(view(path)), nullptr);
+	EXPECT_EQ(cache.load<std::string>(view(path)).get(), nullptr);
+	EXPECT_EQ(cache.stats().failures, 2u);
+	EXPECT_EQ(cache.find<std::string>(view(path)), nullptr);
+}
+
+TEST_F(AssetCache, NestedRequestForQueuedEntry)
+{
+	struct material { puppy::ref<std::string> texture; };
+	const auto texture = write("texture.txt", "pixels");
+	const auto path = write("material.txt", "");
+	puppy::asset_cache cache{{.thread_count = 1}};
+	cache.register_loader<std::string>(text_loader());
+
+	// テクスチャの読み込みが待ち行列に入ってから、唯一のワーカーがそれを同期的に要求する
+	std::promise<void> queued;
+	auto ready = queued.get_future().share();
+	cache.register_loader<material>([&](const fs::path&)
+	{
+		ready.wait();
+		auto value = puppy::make_ref<material>(cache.get<std::string>(view(texture)));
+		return puppy::asset_data<material>{std::move(value), 1};
+	});
+
+	auto future = cache.load<material>(view(path));
+	auto pending = cache.load<std::string>(view(texture));
+	queued.set_value();
+
+	const auto result = future.get();
+	ASSERT_NE(result, nullptr);
+	ASSERT_NE(result->texture, nullptr);
+	EXPECT_EQ(*result->texture, "pixels");
+	EXPECT_EQ(pending.get(), result->texture);
+	EXPECT_EQ(_load_count, 1);
+}
+
+#if PUPPY_PLATFORM_LINUX
+TEST_F(AssetCache, HotReload)
+{
+	const auto path = write("shader.txt", "old");
+	const auto other = write("other.txt", "other");
+	puppy::asset_cache cache;
+	cache.register_loader<std::string>(text_loader());
+	EXPECT_EQ(*cache.get<std::string>(view(path)), "old");
+	EXPECT_EQ(*cache.get<std::string>(view(other)), "other");
+
+	write("shader.txt", "new");
+	for (int i = 0; i < 200 && cache.find<std::string>(view(path)) != nullptr; ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds{10});
+	}
+	EXPECT_EQ(cache.find<std::string>(view(path)), nullptr);
+	EXPECT_NE(cache.find<std::string>(view(other)), nullptr);
+	EXPECT_EQ(*cache.get<std::string>(view(path)), "new");
+	EXPECT_GE(cache.stats().reloads, 1u);
+}
+#endif
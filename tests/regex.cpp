@@ -0,0 +1,227 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <gtest/gtest.h>
+#include <puppy/core/regex.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if PUPPY_PLATFORM_WINDOWS
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+using namespace puppy::literals;
+
+namespace
+{
+	using char_view = puppy::basic_string_view<char>;
+
+	constexpr char_view view_of(const char* str) noexcept
+	{
+		return {str, std::char_traits<char>::length(str)};
+	}
+
+	template<class TView>
+	std::u32string to_string(TView view)
+	{
+		return {view.data(), view.size()};
+	}
+
+	/// @brief スタックの小さいスレッドで関数を実行する
+	void run_with_stack(size_t stack_size, std::function<void()> function)
+	{
+#if PUPPY_PLATFORM_WINDOWS
+		const auto entry = [](LPVOID parameter) -> DWORD
+		{
+			(*static_cast<std::function<void()>*>(parameter))();
+			return 0;
+		};
+		const HANDLE thread = ::CreateThread(nullptr, stack_size, entry, &function, STACK_SIZE_PARAM_IS_A_RESERVATION, nullptr);
+		ASSERT_NE(thread, nullptr);
+		::WaitForSingleObject(thread, INFINITE);
+		::CloseHandle(thread);
+#else
+		pthread_attr_t attributes;
+		::pthread_attr_init(&attributes);
+		::pthread_attr_setstacksize(&attributes, stack_size);
+		const auto entry = [](void* parameter) -> void*
+		{
+			(*static_cast<std::function<void()>*>(parameter))();
+			return nullptr;
+		};
+		pthread_t thread;
+		const int result = ::pthread_create(&thread, &attributes, entry, &function);
+		::pthread_attr_destroy(&attributes);
+		ASSERT_EQ(result, 0);
+		::pthread_join(thread, nullptr);
+#endif
+	}
+
+	// --- 定数式での照合
+	using date = puppy::regex<"(\\d{4})-(\\d{2})-(\\d{2})">;
+	static_assert(date::capture_count == 4);
+	static_assert(date::matches(view_of("2023-04-01")));
+	static_assert(!date::matches(view_of("2023-4-01")));
+	static_assert(date::search(view_of("due 2023-04-01.")).get<2>().compare(view_of("04")) == 0);
+	static_assert(puppy::regex<"a|b*c">::uses_dfa);
+	static_assert(!puppy::regex<"\\bword\\b">::uses_dfa);
+	static_assert(puppy::regex<"\\bword\\b">::contains(view_of("a word here")));
+
+	static_assert(puppy::regex_pattern_error<"a(b"> == puppy::regex_error::unmatched_parenthesis);
+	static_assert(puppy::regex_pattern_error<"a)"> == puppy::regex_error::unmatched_parenthesis);
+	static_assert(puppy::regex_pattern_error<"*a"> == puppy::regex_error::nothing_to_repeat);
+	static_assert(puppy::regex_pattern_error<"a**"> == puppy::regex_error::nothing_to_repeat);
+	static_assert(puppy::regex_pattern_error<"\\b*"> == puppy::regex_error::nothing_to_repeat);
+	static_assert(puppy::regex_pattern_error<"(?:\\b)*"> == puppy::regex_error::none);
+	static_assert(puppy::regex_pattern_error<"(?:$)+"> == puppy::regex_error::none);
+	static_assert(puppy::regex_pattern_error<"[z-a]"> == puppy::regex_error::invalid_class);
+	static_assert(puppy::regex_pattern_error<"a{3,2}"> == puppy::regex_error::invalid_repeat);
+	static_assert(puppy::regex_pattern_error<"(a)\\1"> == puppy::regex_error::unsupported);
+	static_assert(puppy::regex_pattern_error<"\\q"> == puppy::regex_error::invalid_escape);
+	static_assert(puppy::regex_pattern_error<"a{,2}"> == puppy::regex_error::none);
+}
+
+TEST(Regex, Match)
+{
+	using identifier = puppy::regex<U"[A-Za-z_][\\w]*">;
+	EXPECT_TRUE(identifier::matches(U"snake_case_1"_sv));
+	EXPECT_FALSE(identifier::matches(U"1abc"_sv));
+	EXPECT_FALSE(identifier::matches(U""_sv));
+
+	const auto key_value = puppy::regex<U"(\\w+)\\s*=\\s*(\"[^\"]*\"|\\d+)?">::match(U"name = \"puppy\""_sv);
+	ASSERT_TRUE(key_value);
+	EXPECT_EQ(to_string(key_value[1]), U"name");
+	EXPECT_EQ(to_string(key_value[2]), U"\"puppy\"");
+
+	// 参加しなかったグループは空でnposの位置を持つ
+	const auto optional = puppy::regex<U"(a)|(b)">::match(U"b"_sv);
+	ASSERT_TRUE(optional);
+	EXPECT_TRUE(optional[1].empty());
+	EXPECT_EQ(optional.position(1), decltype(optional)::npos);
+	EXPECT_EQ(to_string(optional[2]), U"b");
+
+	EXPECT_TRUE(puppy::regex<U"ab{2,3}c">::matches(U"abbbc"_sv));
+	EXPECT_FALSE(puppy::regex<U"ab{2,3}c">::matches(U"abbbbc"_sv));
+	EXPECT_TRUE(puppy::regex<U"caf\\u00e9|\\u{1F436}+">::matches(U"\U0001F436\U0001F436"_sv));
+	EXPECT_TRUE(puppy::regex<U"[^]*">::matches(U"\n\r"_sv));
+	EXPECT_FALSE(puppy::regex<U".">::matches(U"\n"_sv));
+}
+
+TEST(Regex, SearchSemantics)
+{
+	// 最左のマッチのうち、選択は左側、量指定子は最長 (最短一致の場合は最短) を優先する
+	EXPECT_EQ(to_string(puppy::regex<U"a|ab">::search(U"xab"_sv)[0]), U"a");
+	EXPECT_EQ(to_string(puppy::regex<U"a+">::search(U"baaa"_sv)[0]), U"aaa");
+	EXPECT_EQ(to_string(puppy::regex<U"<.+?>">::search(U"<a><b>"_sv)[0]), U"<a>");
+	EXPECT_EQ(to_string(puppy::regex<U"(a*)*b">::search(U"caab"_sv)[0]), U"aab");
+
+	EXPECT_TRUE(puppy::regex<U"^abc">::contains(U"abcd"_sv));
+	EXPECT_FALSE(puppy::regex<U"^abc">::contains(U"xabc"_sv));
+	EXPECT_TRUE(puppy::regex<U"abc$">::contains(U"xabc"_sv));
+	EXPECT_FALSE(puppy::regex<U"abc$">::contains(U"abcx"_sv));
+	EXPECT_FALSE(puppy::regex<U"^abc">::search(U"abc"_sv, 1));
+
+	const auto word = puppy::regex<U"\\bcat\\b">::search(U"concat cat"_sv);
+	ASSERT_TRUE(word);
+	EXPECT_EQ(word.position(), 7u);
+	EXPECT_TRUE(puppy::regex<U"\\Bcat">::contains(U"concat"_sv));
+
+	// グループで囲んだアサーションは繰り返せる
+	EXPECT_TRUE(puppy::regex<U"a(?:\\b)*b">::matches(U"ab"_sv));
+	EXPECT_TRUE(puppy::regex<U"a(?:$)+">::matches(U"a"_sv));
+	EXPECT_FALSE(puppy::regex<U"a(?:$)+b">::contains(U"ab"_sv));
+}
+
+TEST(Regex, FindAll)
+{
+	std::vector<std::u32string> numbers;
+	for (const auto& match : puppy::regex<U"\\d+">::find_all(U"1, 22 and 333"_sv))
+	{
+		numbers.push_back(to_string(match[0]));
+	}
+	EXPECT_EQ(numbers, (std::vector<std::u32string>{U"1", U"22", U"333"}));
+
+	// 空文字列へのマッチでも1文字ずつ進む
+	size_t count = 0;
+	for (const auto& match : puppy::regex<U"x*">::find_all(U"axxb"_sv))
+	{
+		EXPECT_TRUE(match.length() == 0 || to_string(match[0]) == U"xx");
+		++count;
+	}
+	EXPECT_EQ(count, 4u);
+
+	std::vector<std::pair<std::u32string, std::u32string>> pairs;
+	for (const auto& match : puppy::regex<U"(\\w+)=(\\w*)">::find_all(U"a=1;bb=;c=33"_sv))
+	{
+		pairs.emplace_back(to_string(match.get<1>()), to_string(match.get<2>()));
+	}
+	EXPECT_EQ(pairs.size(), 3u);
+	EXPECT_EQ(pairs[1].first, U"bb");
+	EXPECT_TRUE(pairs[1].second.empty());
+}
+
+TEST(Regex, LiteralPrefix)
+{
+	// 接頭辞の探索がブロック境界をまたいでも正しく動作する
+	std::string text(1000, 'h');
+	text += "hello world";
+	const char_view view{text.data(), text.size()};
+	const auto found = puppy::regex<"hello (\\w+)">::search(view);
+	ASSERT_TRUE(found);
+	EXPECT_EQ(found.position(), 1000u);
+	EXPECT_EQ(found[1].compare(view_of("world")), 0);
+	EXPECT_FALSE(puppy::regex<"hello x">::contains(view));
+
+	const std::u16string wide(u"....................needle!");
+	EXPECT_TRUE(puppy::regex<"needle!">::contains(puppy::basic_string_view<char16_t>{wide.data(), wide.size()}));
+	const std::wstring wstr(L"...................needle");
+	EXPECT_EQ(puppy::regex<"ne+dle">::search(puppy::basic_string_view<wchar_t>{wstr.data(), wstr.size()}).position(), 19u);
+}
+
+TEST(Regex, LargeProgram)
+{
+	// スレッドリストが大きいパターンはスタックを使わずに照合する
+	using large = puppy::regex<"(\\w)(\\w)(\\w)(\\w)(\\w)(\\w)(\\w)(\\w)[a-z]{0,300}!">;
+	static_assert(puppy::detail::regex_engine<"(\\w)(\\w)(\\w)(\\w)(\\w)(\\w)(\\w)(\\w)[a-z]{0,300}!">::heap_threads);
+	static_assert(!puppy::detail::regex_engine<"(\\d{4})-(\\d{2})-(\\d{2})">::heap_threads);
+	static_assert(large::contains(view_of("-- abcdefghij! --")));
+
+	std::string text(2000, '-');
+	text += "abcdefgh" + std::string(300, 'z') + "!";
+	const char_view view{text.data(), text.size()};
+	const auto found = large::search(view);
+	ASSERT_TRUE(found);
+	EXPECT_EQ(found.position(), 2000u);
+	EXPECT_EQ(found[8].compare(view_of("h")), 0);
+	EXPECT_FALSE(large::matches(view));
+}
+
+TEST(Regex, LargeProgramOnSmallStack)
+{
+	// εクロージャの深さがプログラムの大きさに比例しても、ワーカースレッドのスタックを溢れさせない
+	using large = puppy::regex<"(?:a?){800}(?:b?){800}(?:c?){800}(?:d?){800}(?:e?){800}(?:f?){800}(?:g?){800}(?:h?){800}x">;
+	bool contains = false;
+	bool matches = false;
+	size_t position = 0;
+	run_with_stack(256 * 1024, [&]
+	{
+		const std::string text = "--- abcdefgh" + std::string(8, 'x');
+		const char_view view{text.data(), text.size()};
+		contains = large::contains(view);
+		matches = large::matches(view_of("aabbx"));
+		position = large::search(view).position();
+	});
+	EXPECT_TRUE(contains);
+	EXPECT_TRUE(matches);
+	EXPECT_EQ(position, 4u);
+}
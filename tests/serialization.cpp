@@ -0,0 +1,130 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <gtest/gtest.h>
+#include <puppy/core/serialization.hpp>
+
+namespace
+{
+	struct transform
+	{
+		float x, y, z;
+
+		PUPPY_REFLECT(transform, x, y, z);
+	};
+
+	struct entity_v1
+	{
+		std::u32string name;
+		transform position;
+
+		PUPPY_REFLECT(entity_v1, name, position);
+	};
+
+	struct entity_v2
+	{
+		std::u32string name;
+		transform position;
+		std::vector<std::uint32_t> tags;
+
+		PUPPY_REFLECT_VERSIONED(entity_v2, 2, name, position, tags);
+	};
+
+	struct scene
+	{
+		std::string title;
+		std::vector<entity_v2> entities;
+
+		PUPPY_REFLECT(scene, title, entities);
+	};
+
+	struct flags
+	{
+		std::vector<bool> values;
+
+		PUPPY_REFLECT(flags, values);
+	};
+}
+
+TEST(Serialization, InPlaceAccess)
+{
+	const scene source{"level", {{U"player", {1, 2, 3}, {7, 8}}, {U"enemy", {4, 5, 6}, {}}}};
+	const auto buffer = puppy::serialize(source);
+
+	ASSERT_EQ(puppy::verify_serialized(buffer), puppy::serialized_status::ok);
+	const auto root = puppy::serialized_root<scene>(buffer);
+
+	const auto title = root.get<&scene::title>();
+	EXPECT_EQ(std::string_view(title.data(), title.size()), "level");
+	EXPECT_EQ(title.data()[title.size()], '\0');
+
+	const auto entities = root.get<&scene::entities>();
+	ASSERT_EQ(entities.size(), 2u);
+	EXPECT_EQ(entities[0].get<&entity_v2::name>().compare(U"player", 6), 0);
+	EXPECT_EQ(entities[1].get<&entity_v2::position>().get<&transform::z>(), 6.0f);
+
+	const auto tags = entities[0].get<&entity_v2::tags>().span();
+	ASSERT_EQ(tags.size(), 2u);
+	EXPECT_EQ(tags[1], 8u);
+	EXPECT_TRUE(entities[1].get<&entity_v2::tags>().empty());
+}
+
+TEST(Serialization, IteratorOutlivesArray)
+{
+	const auto buffer = puppy::serialize(entity_v2{U"player", {1, 2, 3}, {7, 8, 9}});
+	const auto root = puppy::serialized_root<entity_v2>(buffer);
+
+	// 一時的な配列から取得したイテレータも有効
+	auto it = root.get<&entity_v2::tags>().begin();
+	const auto end = root.get<&entity_v2::tags>().end();
+	std::vector<std::uint32_t> tags;
+	for (; it != end; ++it)
+	{
+		tags.push_back(*it);
+	}
+	EXPECT_EQ(tags, (std::vector<std::uint32_t>{7, 8, 9}));
+}
+
+TEST(Serialization, BoolVector)
+{
+	const auto buffer = puppy::serialize(flags{{true, false, true, true}});
+	const auto values = puppy::serialized_root<flags>(buffer).get<&flags::values>();
+	ASSERT_EQ(values.size(), 4u);
+	EXPECT_TRUE(values[0]);
+	EXPECT_FALSE(values[1]);
+	EXPECT_EQ(std::vector<bool>(values.begin(), values.end()), (std::vector<bool>{true, false, true, true}));
+}
+
+TEST(Serialization, SchemaEvolution)
+{
+	const auto old_buffer = puppy::serialize(entity_v1{U"old", {1, 2, 3}});
+	const auto old_root = puppy::serialized_root<entity_v2>(old_buffer);
+	EXPECT_EQ(puppy::serialized_schema_version(old_buffer), 1u);
+	EXPECT_TRUE(old_root.has<&entity_v2::position>());
+	EXPECT_FALSE(old_root.has<&entity_v2::tags>());
+	EXPECT_TRUE(old_root.get<&entity_v2::tags>().empty());
+
+	const auto new_buffer = puppy::serialize(entity_v2{U"new", {4, 5, 6}, {1}});
+	const auto new_root = puppy::serialized_root<entity_v1>(new_buffer);
+	EXPECT_EQ(new_root.get<&entity_v1::position>().get<&transform::x>(), 4.0f);
+}
+
+TEST(Serialization, Checksum)
+{
+	auto buffer = puppy::serialize(transform{1, 2, 3});
+	ASSERT_EQ(puppy::verify_serialized(buffer), puppy::serialized_status::ok);
+
+	buffer.back() ^= puppy::byte_t{1};
+	EXPECT_EQ(puppy::verify_serialized(buffer), puppy::serialized_status::checksum_mismatch);
+	EXPECT_EQ(puppy::verify_serialized(buffer, false), puppy::serialized_status::ok);
+
+	const std::string_view check = "123456789";
+	EXPECT_EQ(puppy::crc32c(std::as_bytes(std::span{check})), 0xE3069283u);
+}
@@ -0,0 +1,92 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <gtest/gtest.h>
+#include <puppy/core/string_sort.hpp>
+#include <random>
+
+namespace
+{
+	template<class TChar>
+	std::vector<std::basic_string<TChar>> random_strings(size_t count, std::uint32_t seed)
+	{
+		std::mt19937 engine{seed};
+		std::uniform_int_distribution<int> length{0, 24};
+		// 共通接頭辞が長くなるように少ない文字種と固定の接頭辞を混ぜる
+		std::uniform_int_distribution<int> alphabet{0, 3};
+		std::vector<std::basic_string<TChar>> result(count);
+		for (auto& str : result)
+		{
+			if (engine() % 4 == 0)
+			{
+				str.assign(12, static_cast<TChar>('p'));
+			}
+			const int size = length(engine);
+			for (int i = 0; i < size; ++i)
+			{
+				const int c = alphabet(engine);
+				str.push_back(static_cast<TChar>(c == 3 ? -1 : c == 2 ? 0 : 'a' + c));
+			}
+		}
+		return result;
+	}
+
+	template<class TChar>
+	void check_sort(size_t count, size_t thread_count)
+	{
+		const auto strings = random_strings<TChar>(count, 42);
+		std::vector<puppy::basic_string_view<TChar>> views;
+		for (const auto& str : strings)
+		{
+			views.emplace_back(str.data(), str.size());
+		}
+
+		auto expected = views;
+		std::sort(expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs)
+		{
+			return lhs.compare(rhs) < 0;
+		});
+
+		puppy::sort_strings(std::span{views}, thread_count);
+		for (size_t i = 0; i < views.size(); ++i)
+		{
+			ASSERT_EQ(views[i].compare(expected[i]), 0) << "index " << i;
+		}
+	}
+}
+
+TEST(StringSort, MatchesCompare)
+{
+	check_sort<char>(5000, 1);
+	check_sort<wchar_t>(5000, 1);
+	check_sort<char16_t>(5000, 1);
+	check_sort<char32_t>(5000, 1);
+}
+
+TEST(StringSort, Parallel)
+{
+	check_sort<char>(200000, 4);
+	check_sort<char32_t>(200000, 4);
+}
+
+TEST(StringSort, UniqueAndLcp)
+{
+	std::vector<puppy::basic_string_view<char>> views{
+		{"banana", 6}, {"apple", 5}, {"band", 4}, {"apple", 5}, {"ban", 3}};
+	puppy::sort_strings(std::span{views});
+
+	const auto unique = puppy::unique_strings(std::span{views});
+	ASSERT_EQ(unique.size(), 4u);
+	EXPECT_EQ(unique[0].compare("apple", 5), 0);
+	EXPECT_EQ(unique[1].compare("ban", 3), 0);
+
+	const auto lcp = puppy::lcp_array(unique);
+	EXPECT_EQ(lcp, (std::vector<size_t>{0, 0, 3, 3}));
+}
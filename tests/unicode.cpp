@@ -0,0 +1,91 @@
+/*
+ *    ___                        ____                                   __
+ *   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+ *  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+ * /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+ *          /_/  /_/   /___/
+ * Copyright (c) 2023 TarobeWanwanLand.
+ * Released under the MIT license. see http://opensource.org/licenses/MIT
+ */
+
+#include <gtest/gtest.h>
+#include <puppy/core/unicode.hpp>
+#include <vector>
+
+using namespace puppy::literals;
+
+namespace
+{
+	template<class TRange>
+	std::vector<std::u32string> collect(TRange&& range)
+	{
+		std::vector<std::u32string> result;
+		for (const auto segment : range)
+		{
+			result.emplace_back(segment.data(), segment.size());
+		}
+		return result;
+	}
+}
+
+TEST(Unicode, CaseFolding)
+{
+	EXPECT_EQ(puppy::simple_case_fold(U'A'), U'a');
+	EXPECT_EQ(puppy::simple_case_fold(U'Σ'), U'σ');
+	EXPECT_EQ(puppy::simple_case_fold(U'ß'), U'ß');
+
+	char32_t buffer[puppy::max_case_fold_length];
+	ASSERT_EQ(puppy::full_case_fold(U'ß', buffer), 2u);
+	EXPECT_EQ(buffer[0], U's');
+	EXPECT_EQ(buffer[1], U's');
+}
+
+TEST(Unicode, CaseInsensitiveCompare)
+{
+	EXPECT_TRUE(puppy::equals_case_insensitive(U"Hello, World! 0123"_sv, U"hELLO, wORLD! 0123"_sv));
+	EXPECT_TRUE(puppy::equals_case_insensitive(U"STRASSE"_sv, U"straße"_sv));
+	EXPECT_FALSE(puppy::equals_case_insensitive(U"abc"_sv, U"abd"_sv));
+	EXPECT_LT(puppy::compare_case_insensitive(U"apple"_sv, U"BANANA"_sv), 0);
+	EXPECT_GT(puppy::compare_case_insensitive(U"abcd"_sv, U"ABC"_sv), 0);
+
+	EXPECT_EQ(puppy::hash_case_insensitive(U"ΣΊΣΥΦΟΣ"_sv), puppy::hash_case_insensitive(U"σίσυφοσ"_sv));
+	EXPECT_EQ(puppy::hash_case_insensitive(U"Maße"_sv), puppy::hash_case_insensitive(U"MASSE"_sv));
+}
+
+TEST(Unicode, Normalization)
+{
+	const auto composed = U"café 각"_sv;
+	const auto decomposed = U"café 각"_sv;
+
+	EXPECT_EQ(puppy::quick_check(U"plain ascii"_sv, puppy::normalization_form::nfc), puppy::normalization_check::yes);
+	EXPECT_EQ(puppy::quick_check(composed, puppy::normalization_form::nfd), puppy::normalization_check::no);
+	EXPECT_EQ(puppy::quick_check(decomposed, puppy::normalization_form::nfc), puppy::normalization_check::maybe);
+
+	EXPECT_EQ(puppy::normalize(composed, puppy::normalization_form::nfd), std::u32string(decomposed.data(), decomposed.size()));
+	EXPECT_EQ(puppy::normalize(decomposed, puppy::normalization_form::nfc), std::u32string(composed.data(), composed.size()));
+	EXPECT_TRUE(puppy::is_normalized(composed, puppy::normalization_form::nfc));
+	EXPECT_FALSE(puppy::is_normalized(decomposed, puppy::normalization_form::nfc));
+
+	// 結合文字は結合クラス順に並べ替えられる
+	EXPECT_EQ(puppy::normalize(U"ạ́"_sv, puppy::normalization_form::nfd), U"ạ́");
+	EXPECT_EQ(puppy::normalize(U"ạ́"_sv, puppy::normalization_form::nfc), U"ạ́");
+}
+
+TEST(Unicode, Graphemes)
+{
+	const auto clusters = collect(puppy::graphemes(U"aé\r\n\U0001F1EF\U0001F1F5\U0001F1FA\U0001F468‍\U0001F469"_sv));
+	const std::vector<std::u32string> expected{
+		U"a", U"é", U"\r\n", U"\U0001F1EF\U0001F1F5", U"\U0001F1FA", U"\U0001F468‍\U0001F469"};
+	EXPECT_EQ(clusters, expected);
+
+	EXPECT_TRUE(collect(puppy::graphemes(U""_sv)).empty());
+}
+
+TEST(Unicode, Words)
+{
+	const auto segments = collect(puppy::words(U"The quick (\"brown\") fox can't jump 32.3 feet, right?"_sv));
+	const std::vector<std::u32string> expected{
+		U"The", U" ", U"quick", U" ", U"(", U"\"", U"brown", U"\"", U")", U" ", U"fox", U" ",
+		U"can't", U" ", U"jump", U" ", U"32.3", U" ", U"feet", U",", U" ", U"right", U"?"};
+	EXPECT_EQ(segments, expected);
+}
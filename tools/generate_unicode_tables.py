@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+#    ___                        ____                                   __
+#   / _ \__ _____  ___  __ __  / __/______ ___ _  ___ _    _____  ____/ /__
+#  / ___/ // / _ \/ _ \/ // / / _// __/ _ `/  ' \/ -_) |/|/ / _ \/ __/  '_/
+# /_/   \_,_/ .__/ .__/\_, / /_/ /_/  \_,_/_/_/_/\__/|__,__/\___/_/ /_/\_\
+#          /_/  /_/   /___/
+# Copyright (c) 2023 TarobeWanwanLand.
+# Released under the MIT license. see http://opensource.org/licenses/MIT
+
+"""Unicode Character Databaseから多段ルックアップテーブルを生成する
+
+使い方: generate_unicode_tables.py <UCDディレクトリ> <出力ファイル>
+
+src/core/unicode.cppからインクルードされる。プロパティ値の並び順は
+unicode.cppの列挙型と一致させること。
+"""
+
+import os
+import sys
+
+CODE_POINT_COUNT = 0x110000
+
+GRAPHEME_BREAK = [
+    'Other', 'CR', 'LF', 'Control', 'Extend', 'ZWJ', 'Regional_Indicator',
+    'Prepend', 'SpacingMark', 'L', 'V', 'T', 'LV', 'LVT',
+]
+
+WORD_BREAK = [
+    'Other', 'CR', 'LF', 'Newline', 'Extend', 'ZWJ', 'Regional_Indicator',
+    'Format', 'Katakana', 'Hebrew_Letter', 'ALetter', 'Single_Quote',
+    'Double_Quote', 'MidNumLet', 'MidLetter', 'MidNum', 'Numeric',
+    'ExtendNumLet', 'WSegSpace',
+]
+
+QC_YES, QC_NO, QC_MAYBE = 0, 1, 2
+
+
+def read_lines(ucd_dir, name):
+    with open(os.path.join(ucd_dir, name), encoding='utf-8') as file:
+        for line in file:
+            line = line.split('#', 1)[0].strip()
+            if line:
+                yield [field.strip() for field in line.split(';')]
+
+
+def parse_range(text):
+    if '..' in text:
+        first, last = text.split('..')
+        return range(int(first, 16), int(last, 16) + 1)
+    return range(int(text, 16), int(text, 16) + 1)
+
+
+def load_unicode_data(ucd_dir):
+    ccc = [0] * CODE_POINT_COUNT
+    decompositions = {}
+    first = None
+    for fields in read_lines(ucd_dir, 'UnicodeData.txt'):
+        code = int(fields[0], 16)
+        if fields[1].endswith(', First>'):
+            first = code
+            continue
+        codes = range(first, code + 1) if fields[1].endswith(', Last>') else (code,)
+        for c in codes:
+            ccc[c] = int(fields[3])
+        if fields[5] and not fields[5].startswith('<'):
+            decompositions[code] = [int(x, 16) for x in fields[5].split()]
+    return ccc, decompositions
+
+
+def load_property(ucd_dir, name, values):
+    table = [0] * CODE_POINT_COUNT
+    index = {value: i for i, value in enumerate(values)}
+    for fields in read_lines(ucd_dir, name):
+        if fields[1] in index:
+            for c in parse_range(fields[0]):
+                table[c] = index[fields[1]]
+    return table
+
+
+def load_binary_property(ucd_dir, name, prop):
+    result = set()
+    for fields in read_lines(ucd_dir, name):
+        if fields[1] == prop:
+            result.update(parse_range(fields[0]))
+    return result
+
+
+def load_normalization_props(ucd_dir):
+    nfc_qc = [QC_YES] * CODE_POINT_COUNT
+    nfd_qc = [QC_YES] * CODE_POINT_COUNT
+    exclusions = set()
+    for fields in read_lines(ucd_dir, 'DerivedNormalizationProps.txt'):
+        if fields[1] == 'Full_Composition_Exclusion':
+            exclusions.update(parse_range(fields[0]))
+        elif fields[1] in ('NFC_QC', 'NFD_QC'):
+            value = QC_NO if fields[2] == 'N' else QC_MAYBE
+            target = nfc_qc if fields[1] == 'NFC_QC' else nfd_qc
+            for c in parse_range(fields[0]):
+                target[c] = value
+    return nfc_qc, nfd_qc, exclusions
+
+
+def load_case_folding(ucd_dir):
+    simple = {}
+    full = {}
+    for fields in read_lines(ucd_dir, 'CaseFolding.txt'):
+        code = int(fields[0], 16)
+        mapping = [int(x, 16) for x in fields[2].split()]
+        if fields[1] in ('C', 'S'):
+            simple[code] = mapping[0]
+        if fields[1] in ('C', 'F'):
+            full[code] = mapping
+    return simple, full
+
+
+def full_decomposition(code, decompositions):
+    if code not in decompositions:
+        return [code]
+    result = []
+    for c in decompositions[code]:
+        result.extend(full_decomposition(c, decompositions))
+    return result
+
+
+def build_two_stage(values):
+    """ブロックサイズを変えながら、最も小さくなる2段テーブルを返す"""
+    best = None
+    for shift in range(4, 10):
+        size = 1 << shift
+        blocks = {}
+        stage1 = []
+        stage2 = []
+        for start in range(0, CODE_POINT_COUNT, size):
+            block = tuple(values[start:start + size])
+            if block not in blocks:
+                blocks[block] = len(blocks)
+                stage2.extend(block)
+            stage1.append(blocks[block])
+        total = len(stage1) * int_bytes(max(stage1)) + len(stage2) * int_bytes(max(stage2))
+        if best is None or total < best[0]:
+            best = (total, shift, stage1, stage2)
+    return best[1], best[2], best[3]
+
+
+def int_bytes(value):
+    return 1 if value < 0x100 else 2 if value < 0x10000 else 4
+
+
+def int_type(values):
+    return {1: 'std::uint8_t', 2: 'std::uint16_t', 4: 'std::uint32_t'}[int_bytes(max(values))]
+
+
+def emit_array(out, c_type, name, values, per_line=16):
+    out.append(f'\tstatic constexpr {c_type} {name}[] = {{')
+    for i in range(0, len(values), per_line):
+        out.append('\t\t' + ', '.join(str(v) for v in values[i:i + per_line]) + ',')
+    out.append('\t};')
+    out.append('')
+
+
+def emit_two_stage(out, name, values):
+    shift, stage1, stage2 = build_two_stage(values)
+    out.append(f'\tstatic constexpr unsigned {name}_shift = {shift};')
+    emit_array(out, int_type(stage1), f'{name}_stage1', stage1)
+    emit_array(out, int_type(stage2), f'{name}_stage2', stage2)
+
+
+def dedupe(values):
+    """値の一覧を重複のないレコードとそのインデックスに変換する"""
+    records = {}
+    indices = []
+    for value in values:
+        if value not in records:
+            records[value] = len(records)
+        indices.append(records[value])
+    return list(records), indices
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(f'usage: {sys.argv[0]} <ucd-dir> <output>')
+    ucd_dir, output = sys.argv[1], sys.argv[2]
+
+    ccc, decompositions = load_unicode_data(ucd_dir)
+    nfc_qc, nfd_qc, exclusions = load_normalization_props(ucd_dir)
+    grapheme = load_property(ucd_dir, os.path.join('auxiliary', 'GraphemeBreakProperty.txt'), GRAPHEME_BREAK)
+    word = load_property(ucd_dir, os.path.join('auxiliary', 'WordBreakProperty.txt'), WORD_BREAK)
+    pictographic = load_binary_property(ucd_dir, os.path.join('emoji', 'emoji-data.txt'), 'Extended_Pictographic')
+    simple_fold, full_fold = load_case_folding(ucd_dir)
+
+    # 文字プロパティ
+    # bit 0-7: 結合クラス, 8-11: 書記素クラスタ境界, 12-16: 単語境界,
+    # 17: Extended_Pictographic, 18-19: NFC_QC, 20: NFD_QC
+    packed = [
+        ccc[c] | grapheme[c] << 8 | word[c] << 12 | (c in pictographic) << 17
+        | nfc_qc[c] << 18 | (nfd_qc[c] == QC_NO) << 20
+        for c in range(CODE_POINT_COUNT)
+    ]
+    prop_records, prop_indices = dedupe(packed)
+
+    # ケースフォールディング
+    expansions = [[0, 0, 0, 0]]
+    fold_values = []
+    for c in range(CODE_POINT_COUNT):
+        delta = simple_fold.get(c, c) - c
+        full = full_fold.get(c)
+        expansion = 0
+        if full is not None and len(full) > 1:
+            expansion = len(expansions)
+            expansions.append([len(full)] + full + [0] * (3 - len(full)))
+        fold_values.append((delta, expansion))
+    fold_records, fold_indices = dedupe(fold_values)
+
+    # 正準分解
+    decomposition_data = [0]
+    decomposition_indices = [0] * CODE_POINT_COUNT
+    for c in sorted(decompositions):
+        sequence = full_decomposition(c, decompositions)
+        decomposition_indices[c] = len(decomposition_data)
+        decomposition_data.extend([len(sequence)] + sequence)
+
+    # 正準合成
+    compositions = sorted(
+        (d[0] << 21 | d[1], c) for c, d in decompositions.items()
+        if len(d) == 2 and c not in exclusions)
+
+    out = [
+        '// このファイルは tools/generate_unicode_tables.py によって生成される。編集しないこと',
+        '',
+        'namespace puppy::detail::unicode_tables',
+        '{',
+    ]
+    emit_two_stage(out, 'property', prop_indices)
+    emit_array(out, 'std::uint32_t', 'property_records', prop_records)
+    emit_two_stage(out, 'fold', fold_indices)
+    emit_array(out, 'std::int32_t', 'fold_deltas', [r[0] for r in fold_records])
+    emit_array(out, 'std::uint16_t', 'fold_expansion_indices', [r[1] for r in fold_records])
+    emit_array(out, 'char32_t', 'fold_expansions', [v for e in expansions for v in e])
+    emit_two_stage(out, 'decomposition', decomposition_indices)
+    emit_array(out, 'char32_t', 'decomposition_data', decomposition_data)
+    emit_array(out, 'std::uint64_t', 'composition_keys', [k for k, _ in compositions], 8)
+    emit_array(out, 'char32_t', 'composition_values', [v for _, v in compositions])
+    out.append('}')
+    out.append('')
+
+    os.makedirs(os.path.dirname(os.path.abspath(output)), exist_ok=True)
+    with open(output, 'w', encoding='utf-8', newline='\n') as file:
+        file.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()